@@ -40,17 +40,62 @@
 #include <sys/types.h>
 #ifndef __WIN32__
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
+#include <fcntl.h>
 #include <netdb.h>
+#include <poll.h>
+#include <time.h>
 #include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <linux/filter.h>
+#include <sys/sendfile.h>
+#include <linux/errqueue.h>
+#include <sys/syscall.h>
+#if defined (__has_include)
+#if __has_include (<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+#endif
+// io_uring is used through its system calls, from Linux 5.7 headers on
+#if defined (__NR_io_uring_setup) && defined (IORING_FEAT_FAST_POLL)
+#define HAVE_IO_URING 1
+#endif
+#endif
 #else
 typedef unsigned int socklen_t;
 #include <winsock2.h>
+#include <ws2tcpip.h>
+struct iovec
+{
+  void* iov_base;
+  size_t iov_len;
+};
 #endif
 #include <errno.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <vector>
+#ifndef __WIN32__
+#include <atomic>
+#include <thread>
+#endif
+
 /*
  * macro for defining all the socket constants as
  * octave functions.
@@ -60,6 +105,16 @@ typedef unsigned int socklen_t;
                "socket constant")                          \
   {    return octave_value( name ); };
 
+/*
+ * macro for defining the socket constants that do not exist on this
+ * platform, so that their autoload still finds a function.
+ */
+# define DEFUN_DLD_SOCKET_CONSTANT_NOT_SUPPORTED(name)\
+  DEFUNX_DLD ( #name, F ## name, G ## name, args, nargout, \
+               "(not supported)")                          \
+  { error ( #name " not supported on this platform" );     \
+    return octave_value (); };
+
 
 // PKG_ADD: autoload ("AF_UNIX", which ("socket"));
 // PKG_DEL: try; autoload ("AF_UNIX", which ("socket"), "remove"); catch; end;
@@ -79,7 +134,9 @@ DEFUN_DLD_SOCKET_CONSTANT(AF_INET );
 // PKG_ADD: autoload ("AF_APPLETALK", which ("socket"));
 // PKG_DEL: try; autoload ("AF_APPLETALK", which ("socket"), "remove"); catch; end;
 DEFUN_DLD_SOCKET_CONSTANT(AF_APPLETALK );
-//DEFUN_DLD_SOCKET_CONSTANT(AF_INET6 );
+// PKG_ADD: autoload ("AF_INET6", which ("socket"));
+// PKG_DEL: try; autoload ("AF_INET6", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(AF_INET6 );
 //DEFUN_DLD_SOCKET_CONSTANT(AF_IPX );
 //DEFUN_DLD_SOCKET_CONSTANT(AF_NETLINK );
 //DEFUN_DLD_SOCKET_CONSTANT(AF_X25 );
@@ -132,469 +189,8146 @@ DEFUN_DLD_SOCKET_CONSTANT(SO_DEBUG );
 // PKG_ADD: autoload ("SO_REUSEADDR", which ("socket"));
 // PKG_DEL: try; autoload ("SO_REUSEADDR", which ("socket"), "remove"); catch; end;
 DEFUN_DLD_SOCKET_CONSTANT(SO_REUSEADDR );
+#ifdef SO_REUSEPORT
+// PKG_ADD: autoload ("SO_REUSEPORT", which ("socket"));
+// PKG_DEL: try; autoload ("SO_REUSEPORT", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(SO_REUSEPORT );
+#else
+DEFUN_DLD_SOCKET_CONSTANT_NOT_SUPPORTED(SO_REUSEPORT );
+#endif
+// PKG_ADD: autoload ("SO_KEEPALIVE", which ("socket"));
+// PKG_DEL: try; autoload ("SO_KEEPALIVE", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(SO_KEEPALIVE );
+// PKG_ADD: autoload ("SO_SNDBUF", which ("socket"));
+// PKG_DEL: try; autoload ("SO_SNDBUF", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(SO_SNDBUF );
+// PKG_ADD: autoload ("SO_RCVBUF", which ("socket"));
+// PKG_DEL: try; autoload ("SO_RCVBUF", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(SO_RCVBUF );
+// PKG_ADD: autoload ("SO_RCVLOWAT", which ("socket"));
+// PKG_DEL: try; autoload ("SO_RCVLOWAT", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(SO_RCVLOWAT );
+// PKG_ADD: autoload ("SO_RCVTIMEO", which ("socket"));
+// PKG_DEL: try; autoload ("SO_RCVTIMEO", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(SO_RCVTIMEO );
+// PKG_ADD: autoload ("SO_SNDTIMEO", which ("socket"));
+// PKG_DEL: try; autoload ("SO_SNDTIMEO", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(SO_SNDTIMEO );
+// PKG_ADD: autoload ("SO_LINGER", which ("socket"));
+// PKG_DEL: try; autoload ("SO_LINGER", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(SO_LINGER );
+#ifdef SO_BUSY_POLL
+// PKG_ADD: autoload ("SO_BUSY_POLL", which ("socket"));
+// PKG_DEL: try; autoload ("SO_BUSY_POLL", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(SO_BUSY_POLL );
+#else
+DEFUN_DLD_SOCKET_CONSTANT_NOT_SUPPORTED(SO_BUSY_POLL );
+#endif
 
-//we need to keep track if sockets has been loaded, as it
-//requires initialization on windows platforms.
-#ifdef __WIN32__
-static bool type_loaded = false;
+// PKG_ADD: autoload ("IPPROTO_TCP", which ("socket"));
+// PKG_DEL: try; autoload ("IPPROTO_TCP", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(IPPROTO_TCP );
+// PKG_ADD: autoload ("TCP_NODELAY", which ("socket"));
+// PKG_DEL: try; autoload ("TCP_NODELAY", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(TCP_NODELAY );
+#ifdef TCP_QUICKACK
+// PKG_ADD: autoload ("TCP_QUICKACK", which ("socket"));
+// PKG_DEL: try; autoload ("TCP_QUICKACK", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(TCP_QUICKACK );
+#else
+DEFUN_DLD_SOCKET_CONSTANT_NOT_SUPPORTED(TCP_QUICKACK );
+#endif
+#ifdef TCP_CORK
+// PKG_ADD: autoload ("TCP_CORK", which ("socket"));
+// PKG_DEL: try; autoload ("TCP_CORK", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(TCP_CORK );
+#else
+DEFUN_DLD_SOCKET_CONSTANT_NOT_SUPPORTED(TCP_CORK );
+#endif
+#if defined (TCP_KEEPIDLE) && defined (TCP_KEEPINTVL) && defined (TCP_KEEPCNT)
+// PKG_ADD: autoload ("TCP_KEEPIDLE", which ("socket"));
+// PKG_DEL: try; autoload ("TCP_KEEPIDLE", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(TCP_KEEPIDLE );
+// PKG_ADD: autoload ("TCP_KEEPINTVL", which ("socket"));
+// PKG_DEL: try; autoload ("TCP_KEEPINTVL", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(TCP_KEEPINTVL );
+// PKG_ADD: autoload ("TCP_KEEPCNT", which ("socket"));
+// PKG_DEL: try; autoload ("TCP_KEEPCNT", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(TCP_KEEPCNT );
+#else
+DEFUN_DLD_SOCKET_CONSTANT_NOT_SUPPORTED(TCP_KEEPIDLE );
+DEFUN_DLD_SOCKET_CONSTANT_NOT_SUPPORTED(TCP_KEEPINTVL );
+DEFUN_DLD_SOCKET_CONSTANT_NOT_SUPPORTED(TCP_KEEPCNT );
+#endif
+#ifdef __linux__
+// PKG_ADD: autoload ("TCP_INFO", which ("socket"));
+// PKG_DEL: try; autoload ("TCP_INFO", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(TCP_INFO );
+#else
+DEFUN_DLD_SOCKET_CONSTANT_NOT_SUPPORTED(TCP_INFO );
 #endif
 
-// PKG_ADD: autoload ("socket", which ("socket"));
-// PKG_DEL: try; autoload ("socket", which ("socket"), "remove"); catch; end;
-// Function to create a socket
-DEFUN_DLD(socket, args, , "\
--*- texinfo -*-\n\
-@deftypefn  {Loadable Function} {} socket ()\n\
-@deftypefnx {Loadable Function} {} socket (@var{domain})\n\
-@deftypefnx {Loadable Function} {} socket (@var{domain}, @var{type})\n\
-@deftypefnx {Loadable Function} {} socket (@var{domain}, @var{type}, @var{protocol})\n\
-Creates a socket.\n\
-\n\
-@var{domain} is an integer, where the value AF_INET\n\
-can be used to create an IPv4 socket.\n\
-\n\
-@var{type} is an integer describing the socket.  When using IP, specifying\n\
-SOCK_STREAM gives a TCP socket.\n\
-\n\
-@var{protocol} is currently not used and should be 0 if specified.\n\
-\n\
-If no input arguments are given, default values AF_INET and\n\
-SOCK_STREAM are used.\n\
-\n\
-See the local @command{socket} reference for more details.\n\
-@end deftypefn")
+// PKG_ADD: autoload ("IPPROTO_IPV6", which ("socket"));
+// PKG_DEL: try; autoload ("IPPROTO_IPV6", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(IPPROTO_IPV6 );
+// PKG_ADD: autoload ("IPV6_V6ONLY", which ("socket"));
+// PKG_DEL: try; autoload ("IPV6_V6ONLY", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(IPV6_V6ONLY );
+
+/*
+ * event masks for poll
+ */
+#ifndef __WIN32__
+// PKG_ADD: autoload ("POLLIN", which ("socket"));
+// PKG_DEL: try; autoload ("POLLIN", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(POLLIN );
+// PKG_ADD: autoload ("POLLPRI", which ("socket"));
+// PKG_DEL: try; autoload ("POLLPRI", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(POLLPRI );
+// PKG_ADD: autoload ("POLLOUT", which ("socket"));
+// PKG_DEL: try; autoload ("POLLOUT", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(POLLOUT );
+// PKG_ADD: autoload ("POLLERR", which ("socket"));
+// PKG_DEL: try; autoload ("POLLERR", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(POLLERR );
+// PKG_ADD: autoload ("POLLHUP", which ("socket"));
+// PKG_DEL: try; autoload ("POLLHUP", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(POLLHUP );
+// PKG_ADD: autoload ("POLLNVAL", which ("socket"));
+// PKG_DEL: try; autoload ("POLLNVAL", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(POLLNVAL );
+#else
+DEFUN_DLD_SOCKET_CONSTANT_NOT_SUPPORTED(POLLIN );
+DEFUN_DLD_SOCKET_CONSTANT_NOT_SUPPORTED(POLLPRI );
+DEFUN_DLD_SOCKET_CONSTANT_NOT_SUPPORTED(POLLOUT );
+DEFUN_DLD_SOCKET_CONSTANT_NOT_SUPPORTED(POLLERR );
+DEFUN_DLD_SOCKET_CONSTANT_NOT_SUPPORTED(POLLHUP );
+DEFUN_DLD_SOCKET_CONSTANT_NOT_SUPPORTED(POLLNVAL );
+#endif
+
+/*
+ * event masks for the epoll event loop
+ */
+#ifdef __linux__
+// PKG_ADD: autoload ("EPOLLIN", which ("socket"));
+// PKG_DEL: try; autoload ("EPOLLIN", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(EPOLLIN );
+// PKG_ADD: autoload ("EPOLLPRI", which ("socket"));
+// PKG_DEL: try; autoload ("EPOLLPRI", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(EPOLLPRI );
+// PKG_ADD: autoload ("EPOLLOUT", which ("socket"));
+// PKG_DEL: try; autoload ("EPOLLOUT", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(EPOLLOUT );
+// PKG_ADD: autoload ("EPOLLERR", which ("socket"));
+// PKG_DEL: try; autoload ("EPOLLERR", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(EPOLLERR );
+// PKG_ADD: autoload ("EPOLLHUP", which ("socket"));
+// PKG_DEL: try; autoload ("EPOLLHUP", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(EPOLLHUP );
+// PKG_ADD: autoload ("EPOLLRDHUP", which ("socket"));
+// PKG_DEL: try; autoload ("EPOLLRDHUP", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(EPOLLRDHUP );
+// PKG_ADD: autoload ("EPOLLET", which ("socket"));
+// PKG_DEL: try; autoload ("EPOLLET", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(EPOLLET );
+// PKG_ADD: autoload ("EPOLLONESHOT", which ("socket"));
+// PKG_DEL: try; autoload ("EPOLLONESHOT", which ("socket"), "remove"); catch; end;
+DEFUN_DLD_SOCKET_CONSTANT(EPOLLONESHOT );
+#else
+DEFUN_DLD_SOCKET_CONSTANT_NOT_SUPPORTED(EPOLLIN );
+DEFUN_DLD_SOCKET_CONSTANT_NOT_SUPPORTED(EPOLLPRI );
+DEFUN_DLD_SOCKET_CONSTANT_NOT_SUPPORTED(EPOLLOUT );
+DEFUN_DLD_SOCKET_CONSTANT_NOT_SUPPORTED(EPOLLERR );
+DEFUN_DLD_SOCKET_CONSTANT_NOT_SUPPORTED(EPOLLHUP );
+DEFUN_DLD_SOCKET_CONSTANT_NOT_SUPPORTED(EPOLLRDHUP );
+DEFUN_DLD_SOCKET_CONSTANT_NOT_SUPPORTED(EPOLLET );
+DEFUN_DLD_SOCKET_CONSTANT_NOT_SUPPORTED(EPOLLONESHOT );
+#endif
+
+/*
+ * An uninitialized array of one of the classes of class_word_size, to
+ * receive data straight into its storage.  Only "double" and "single"
+ * can be complex.  The octave value is only built by value () once the
+ * storage has been filled, as building it can narrow the array, e.g.
+ * turn a single element into a scalar holding a copy of the still
+ * uninitialized data.  Copies share the array.
+ */
+class recv_array
 {
-  int domain    = AF_INET;
-  int type      = SOCK_STREAM;
-  int protocol  = 0;
+public:
+  recv_array () : buf (0) { }
 
-#ifdef __WIN32__
-  if (! type_loaded)
-    {
-      type_loaded = true;
+  recv_array (const std::string& cls, const dim_vector& dv,
+              bool iscomplex = false);
 
-      WORD wVersionRequested;
-      WSADATA wsaData;
-      int err;
+  // the storage, which must not be written to once value () was called
+  char* data () const { return buf; }
 
-      wVersionRequested = MAKEWORD (2, 2);
-      err = WSAStartup (wVersionRequested, &wsaData);
-      if (err != 0)
-        {
-          error ("socket: could not initialize winsock library");
-          return octave_value();
-        }
-    }
-#endif
+  size_t byte_size () const { return rep ? rep->byte_size () : 0; }
 
-  // Convert the arguments to their #define'd value
-  const octave_idx_type nargin = args.length ();
-  if (nargin > 0)
-    {
-      domain = args(0).int_value ();
-      if (error_state)
-        {
-          error ("socket: DOMAIN must be a scalar integer");
-          return octave_value ();
-        }
-    }
+  octave_value value () const
+  { return rep ? rep->value () : octave_value (); }
 
-  if (nargin > 1)
-    {
-      type = args(1).int_value ();
-      if (error_state)
-        {
-          error ("socket: TYPE must be a scalar integer");
-          return octave_value ();
-        }
-    }
+private:
+  struct base_rep
+  {
+    virtual ~base_rep () { }
+    virtual size_t byte_size () const = 0;
+    virtual octave_value value () const = 0;
+  };
 
-  if (nargin > 2)
-    {
-      protocol = args(2).int_value ();
-      if (error_state)
-        {
-          error ("socket: PROTOCOL must be a scalar integer");
-          return octave_value ();
-        }
-      else if (protocol != 0)
-      {
-        error ("socket: for now, PROTOCOL must always be 0 (zero)");
-        return octave_value ();
-      }
-    }
+  template <typename NDA>
+  struct typed_rep : public base_rep
+  {
+    typed_rep (const dim_vector& dv) : array (dv) { }
+    size_t byte_size () const { return array.byte_size (); }
+    octave_value value () const { return octave_value (array); }
+    NDA array;
+  };
 
-  // Create the new socket
-  const int sock_fd = ::socket (domain, type, protocol);
-  if (sock_fd == -1)
-      error ("socket failed with error %i (%s)", errno, strerror(errno));
+  template <typename NDA>
+  void allocate (const dim_vector& dv)
+  {
+    typed_rep<NDA>* r = new typed_rep<NDA> (dv);
+    rep.reset (r);
+    buf = reinterpret_cast<char*> (r->array.fortran_vec ());
+  }
+
+  std::shared_ptr<base_rep> rep;
+  char* buf;
+};
 
-  return octave_value(sock_fd);
+recv_array::recv_array (const std::string& cls, const dim_vector& dv,
+                        bool iscomplex)
+  : buf (0)
+{
+  if (cls == "uint8")
+    allocate<uint8NDArray> (dv);
+  else if (cls == "int8")
+    allocate<int8NDArray> (dv);
+  else if (cls == "uint16")
+    allocate<uint16NDArray> (dv);
+  else if (cls == "int16")
+    allocate<int16NDArray> (dv);
+  else if (cls == "uint32")
+    allocate<uint32NDArray> (dv);
+  else if (cls == "int32")
+    allocate<int32NDArray> (dv);
+  else if (cls == "uint64")
+    allocate<uint64NDArray> (dv);
+  else if (cls == "int64")
+    allocate<int64NDArray> (dv);
+  else if (cls == "single" && iscomplex)
+    allocate<FloatComplexNDArray> (dv);
+  else if (cls == "single")
+    allocate<FloatNDArray> (dv);
+  else if (cls == "double" && iscomplex)
+    allocate<ComplexNDArray> (dv);
+  else if (cls == "double")
+    allocate<NDArray> (dv);
+  else if (cls == "char")
+    allocate<charNDArray> (dv);
+  else
+    allocate<boolNDArray> (dv);
 }
 
 /*
- * helper function to convert an octave value to an integer,
- * returning -1 if it failed.
+ * state of recv_msg for one socket: bytes read ahead from the socket
+ * into STAGE, and the message being reassembled into MSG.
  */
-int get_socket(const octave_value& arg)
+struct msg_reader
 {
-  const int fd = arg.int_value();
-  if (error_state)
-    {
-      return -1;
-    }
-  return fd;
-}
+  msg_reader ()
+    : stage_pos (0), stage_end (0), have_header (false), msg_len (0),
+      msg_have (0)
+  { }
 
+  std::vector<char> stage;
+  size_t stage_pos;
+  size_t stage_end;
+
+  bool have_header;
+  size_t msg_len;
+  recv_array msg;
+  size_t msg_have;
+};
 
 /*
- * closes the given socket file descriptor
+ * helper function returning a monotonic time in seconds.
  */
-inline void close_octavesocket(const int sock_fd) {
+static double monotonic_time ()
+{
 #ifndef __WIN32__
-  ::close (sock_fd);
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
 #else
-  ::closesocket (sock_fd);
+  return GetTickCount () * 1e-3;
 #endif
 }
 
-// PKG_ADD: autoload ("connect", which ("socket"));
-// PKG_DEL: try; autoload ("connect", which ("socket"), "remove"); catch; end;
-// function to create an outgoing connection
-DEFUN_DLD(connect, args, , "\
--*- texinfo -*-\n\
-@deftypefn {Loadable Function} {} connect (@var{s}, @var{serverinfo})\n\
-Connect socket.\n\
-\n\
-Connects the socket @var{s} following the information\n\
-in the struct @var{serverinfo} which must contain the\n\
-following fields:\n\
-\n\
-@table @code\n\
-@item addr\n\
-a string with the host name to connect to\n\
-\n\
-@item port\n\
-the port number to connect to (an integer)\n\
-@end table\n\
-\n\
-On successful connect, the returned status is zero.\n\
-\n\
-See the @command{connect} man pages for further details.\n\
-@end deftypefn")
+/*
+ * kinds of system calls counted by socket_stats.
+ */
+enum io_kind
 {
+  IO_SEND = 0,
+  IO_RECV,
+  IO_ACCEPT,
+  IO_KINDS
+};
 
-  if (args.length () != 2)
-    {
-      print_usage ();
-      return octave_value ();
-    }
+static const char* io_kind_names[IO_KINDS] = { "send", "recv", "accept" };
 
-  // Determine the socket on which to operate
-  const int s = get_socket (args(0));
-  if (error_state)
-    {
-      error ("connect: S must be a valid socket");
-      return octave_value ();
-    }
+// bucket 0 counts calls under 1 us, bucket k calls from 2^(k-1) us to
+// 2^k us, and the last bucket everything longer.
+static const int io_hist_buckets = 24;
 
-  // Extract information about the server to connect to.
-  const octave_scalar_map struct_serverInfo = args(1).scalar_map_value ();
-  if (error_state)
-    {
-      error ("connect: SERVERINFO must be a struct");
-      return octave_value ();
-    }
+/*
+ * I/O counters of one socket, or of all of them.  The byte counters are
+ * always kept, the others only while socket_stats is enabled.
+ */
+struct io_stats
+{
+  void reset () { memset (this, 0, sizeof (*this)); }
 
-  const std::string addr = struct_serverInfo.getfield ("addr").string_value ();
-  const int port    = struct_serverInfo.getfield ("port").int_value ();
-  if (error_state)
-    {
-      error ("connect: SERVERINFO must have a string and integer in fields \"addr\" and \"port\"");
-      return octave_value ();
-    }
-  else if (addr.empty ())
-    {
-      error ("connect: SERVERINFO addr is an empty string");
-      return octave_value ();
-    }
+  double bytes_sent;
+  double bytes_received;
 
-  // Fill in the server info struct
-  struct sockaddr_in serverInfo;
-  serverInfo.sin_family = AF_INET;
+  double calls[IO_KINDS];
+  double time[IO_KINDS];
+  double hist[IO_KINDS][io_hist_buckets];
 
-  struct hostent* hostInfo = gethostbyname (addr.c_str ());
-  if (! hostInfo)
-    {
-      error ("connect: error in gethostbyname()");
-      return octave_value ();
-    }
-  serverInfo.sin_addr.s_addr = *((long*)hostInfo->h_addr_list[0]);
-  serverInfo.sin_port = htons(port);
+  double eagain;
+  double eintr;
+  double short_writes;
+  double short_reads;
 
-  const int retval = connect (s, (struct sockaddr*)&serverInfo,
-                              sizeof (struct sockaddr));
-  if (retval == -1)
-      error ("connect failed with error %i (%s)", errno, strerror(errno));
+  double zerocopy_sends;
+  double zerocopy_completions;
+  double zerocopy_copied;
+};
 
-  return octave_value (retval);
+static bool io_stats_enabled = false;
+static io_stats global_io_stats;
+
+/*
+ * state kept between calls for each socket descriptor, whether it is
+ * used through an octave_socket or as a plain integer.
+ */
+/*
+ * a part of the data queued by send_multi for a slow socket: bytes OFF
+ * to LEN of BUF, the storage of DATA, which keeps it alive.
+ */
+struct out_chunk
+{
+  octave_value data;
+  const char* buf;
+  size_t off;
+  size_t len;
+  int flags;
+};
+
+struct socket_state
+{
+  socket_state ()
+    : have_peer (false), zc_enabled (false), zc_next_id (0), out_queued (0)
+  {
+    stats.reset ();
+  }
+
+  msg_reader reader;
+
+  io_stats stats;
+
+  // the peer given to connect or returned by accept
+  bool have_peer;
+  struct sockaddr_storage peer;
+
+  // arrays sent with MSG_ZEROCOPY, kept alive until the kernel is done
+  // with them, with the id the kernel gave to their send
+  bool zc_enabled;
+  uint32_t zc_next_id;
+  std::deque<std::pair<uint32_t, octave_value> > zc_pending;
+
+  // data send_multi could not send yet, and its total size
+  std::deque<out_chunk> out_queue;
+  size_t out_queued;
+
+  // bytes of an incomplete element left over by recv, recvall or
+  // recvfrom, handed out first by the next of them
+  std::string recv_rest;
+};
+
+static std::map<int, socket_state> socket_states;
+
+// sockets a system call found not to be open.  Their state is dropped
+// by the next get_socket rather than right away, as the caller may still
+// hold a reference into socket_states.
+static std::set<int> stale_sockets;
+
+/*
+ * helper function returning the start time of a system call to pass to
+ * count_io, or 0 if socket_stats is disabled.
+ */
+static inline double io_clock ()
+{
+  return io_stats_enabled ? monotonic_time () : 0;
 }
 
-// PKG_ADD: autoload ("disconnect", which ("socket"));
-// PKG_DEL: try ; autoload ("disconnect", which ("socket"), "remove") ; catch ; end;
-// function to disconnect asocket
-DEFUN_DLD(disconnect, args, , "\
--*- texinfo -*-\n\
-@deftypefn {Loadable Function} {} disconnect (@var{s})\n\
-Disconnect socket.\n\
-\n\
-Disconnects the socket @var{s}.  If successful, @code{disconnect} returns 0,\n\
-otherwise, it returns -1.\n\
-\n\
-Since we can't call fclose on the file descriptor directly, use this\n\
-function to disconnect the socket.\n\
-\n\
-@end deftypefn")
+/*
+ * helper function to count N bytes sent, or received if SENT is false,
+ * on socket S.
+ */
+static void count_bytes (int s, ssize_t n, bool sent)
 {
-  if (args.length () != 1)
+  if (n <= 0)
+    return;
+  io_stats& st = socket_states[s].stats;
+  if (sent)
     {
-      print_usage ();
-      return octave_value ();
+      st.bytes_sent += n;
+      global_io_stats.bytes_sent += n;
+    }
+  else
+    {
+      st.bytes_received += n;
+      global_io_stats.bytes_received += n;
     }
+}
 
-  int retval = -1;
-  const int s = get_socket (args(0));
-  if (! error_state)
+/*
+ * helper function to add a call to the counters ST, see count_call.
+ */
+static void add_call (io_stats& st, io_kind kind, bool failed, int err,
+                      bool short_io, double dt, int bucket)
+{
+  st.calls[kind]++;
+  st.time[kind] += dt;
+  st.hist[kind][bucket]++;
+  if (failed && (err == EAGAIN || err == EWOULDBLOCK))
+    st.eagain++;
+  else if (failed && err == EINTR)
+    st.eintr++;
+  else if (short_io && kind == IO_SEND)
+    st.short_writes++;
+  else if (short_io)
+    st.short_reads++;
+}
+
+/*
+ * helper function to count a system call of KIND on socket S started
+ * at T0, as returned by io_clock.  FAILED tells whether it failed with
+ * errno set, and SHORT_IO whether it transferred less than asked.
+ * errno is preserved.  If S turned out not to be open, it is marked
+ * stale.
+ */
+static void count_call (int s, io_kind kind, bool failed, bool short_io,
+                        double t0)
+{
+  const bool bad_fd = failed && errno == EBADF;
+  if (bad_fd)
+    stale_sockets.insert (s);
+  if (! io_stats_enabled || t0 == 0)
+    return;
+
+  const int err = errno;
+  const double dt = std::max (monotonic_time () - t0, 0.0);
+  int bucket = 0;
+  if (dt >= 1e-6)
     {
-      close_octavesocket(s);
-      retval = 0;
+      frexp (dt * 1e6, &bucket);
+      bucket = std::min (bucket, io_hist_buckets - 1);
     }
-  return octave_value (retval);
+
+  if (! bad_fd)
+    add_call (socket_states[s].stats, kind, failed, err, short_io, dt,
+              bucket);
+  add_call (global_io_stats, kind, failed, err, short_io, dt, bucket);
+  errno = err;
 }
 
-// PKG_ADD: autoload ("gethostbyname", which ("socket"));
-// PKG_DEL: try; autoload ("gethostbyname", which ("socket"), "remove"); ; catch; end;
-// function to get a host number from a host name
-DEFUN_DLD(gethostbyname, args, , "\
--*- texinfo -*-\n\
-@deftypefn {Loadable Function} {} gethostbyname (@var{hostname})\n\
-Return IP address for host name.\n\
-\n\
+/*
+ * helper function to count a send or recv of KIND on socket S started at
+ * T0 which returned N for WANT bytes.
+ */
+static inline void count_io (int s, io_kind kind, ssize_t n, size_t want,
+                             double t0)
+{
+  count_bytes (s, n, kind == IO_SEND);
+  count_call (s, kind, n < 0, n > 0 && size_t (n) < want, t0);
+}
+
+#ifndef __WIN32__
+/*
+ * state of recv_async for one socket.  A reader thread drains the
+ * socket into RING, a single-producer/single-consumer ring buffer.  The
+ * thread only advances HEAD and the consumer only advances TAIL, both
+ * counting bytes since the start, so no locks are needed.  A side that
+ * has to wait for the other sets WANT_ROOM or WANT_DATA and sleeps on a
+ * pipe, which the other side writes to once it has made progress.  The
+ * thread must not call into octave.
+ */
+struct async_reader
+{
+  async_reader (int sock_fd, size_t size)
+    : fd (sock_fd), ring (size), mask (size - 1), head (0), tail (0),
+      bytes_received (0), recv_calls (0), ring_full (0), done (false),
+      err (0), want_room (false), want_data (false)
+  {
+    wake[0] = wake[1] = -1;
+    ready[0] = ready[1] = -1;
+  }
+
+  int fd;
+  std::vector<char> ring;
+  size_t mask;
+  std::atomic<uint64_t> head;
+  std::atomic<uint64_t> tail;
+
+  std::atomic<uint64_t> bytes_received;
+  std::atomic<uint64_t> recv_calls;
+  std::atomic<uint64_t> ring_full;
+  // set by the thread when it exits, with errno in ERR after an error
+  std::atomic<bool> done;
+  std::atomic<int> err;
+
+  // set by the thread while the ring is full, and by recv_async_read
+  // while waiting for data
+  std::atomic<bool> want_room;
+  std::atomic<bool> want_data;
+
+  // writing 0 to WAKE[1] tells the thread to exit, and 1 that there is
+  // room in the ring again
+  int wake[2];
+  // written to by the thread when data arrives or it exits
+  int ready[2];
+  std::thread thread;
+};
+
+/*
+ * helper function to write a byte C to the pipe WAKE, waking its reader.
+ */
+static void async_notify (int wake, char c)
+{
+  while (::write (wake, &c, 1) == -1 && errno == EINTR)
+    ;
+}
+
+static void async_reader_loop (async_reader* r)
+{
+  const size_t size = r->ring.size ();
+  for (;;)
+    {
+      struct pollfd pfd[2];
+      pfd[0].fd = r->wake[0];
+      pfd[0].events = POLLIN;
+      pfd[1].fd = r->fd;
+      pfd[1].events = POLLIN;
+      pfd[0].revents = pfd[1].revents = 0;
+
+      // When the ring is full, only wait for it to be drained, checking
+      // again once the consumer knows to wake us
+      const uint64_t head = r->head.load (std::memory_order_relaxed);
+      size_t space = size - (head - r->tail.load ());
+      if (space == 0)
+        {
+          r->ring_full++;
+          r->want_room = true;
+          space = size - (head - r->tail.load ());
+          if (space != 0)
+            r->want_room = false;
+        }
+      if (::poll (pfd, space == 0 ? 1 : 2, -1) == -1)
+        {
+          if (errno == EINTR)
+            continue;
+          r->err = errno;
+          break;
+        }
+      if (pfd[0].revents)
+        {
+          char c[64];
+          const ssize_t n = ::read (r->wake[0], c, sizeof (c));
+          if (n == -1 && errno == EINTR)
+            continue;
+          else if (n <= 0 || memchr (c, 0, n))
+            break;
+          continue;
+        }
+      if (space == 0 || ! pfd[1].revents)
+        continue;
+
+      const size_t pos = head & r->mask;
+      const ssize_t n = ::recv (r->fd, &r->ring[pos],
+                                std::min (space, size - pos), MSG_DONTWAIT);
+      r->recv_calls++;
+      if (n > 0)
+        {
+          r->bytes_received += n;
+          r->head.store (head + n);
+          if (r->want_data.exchange (false))
+            async_notify (r->ready[1], 1);
+        }
+      else if (n == 0)
+        break;
+      else if (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+          r->err = errno;
+          break;
+        }
+    }
+  r->done = true;
+  async_notify (r->ready[1], 1);
+}
+
+static std::map<int, async_reader*> async_readers;
+
+/*
+ * stops the reader thread of socket SOCK_FD, if any, and frees its ring
+ */
+static void stop_async_reader (int sock_fd)
+{
+  std::map<int, async_reader*>::iterator it = async_readers.find (sock_fd);
+  if (it == async_readers.end ())
+    return;
+
+  async_reader* r = it->second;
+  async_notify (r->wake[1], 0);
+  r->thread.join ();
+  ::close (r->wake[0]);
+  ::close (r->wake[1]);
+  ::close (r->ready[0]);
+  ::close (r->ready[1]);
+  delete r;
+  async_readers.erase (it);
+}
+#endif
+
+#ifdef HAVE_IO_URING
+/*
+ * state of a ring created by uring_create.  The submission and
+ * completion queues are shared with the kernel: it consumes submissions
+ * up to SQ_TAIL, which is only published in uring_flush, and appends
+ * completions at CQ_TAIL.  Each queued operation is kept in OPS until
+ * its last completion, under the tag passed as user_data; tag 0 marks
+ * the internal operations returning buffers to POOL.
+ */
+enum uring_kind {URING_SEND, URING_RECV, URING_ACCEPT};
+
+struct uring_op
+{
+  uring_kind kind;
+  int fd;
+  bool multishot;
+  // the array being sent, so that its storage stays alive
+  octave_value data;
+  // the buffer received into, unless taken from the pool
+  std::vector<char> buf;
+};
+
+struct uring_state
+{
+  int fd;
+  unsigned sq_entries;
+  void* sq_ring;
+  size_t sq_ring_size;
+  void* cq_ring;
+  size_t cq_ring_size;
+  struct io_uring_sqe* sqes;
+  size_t sqes_size;
+
+  unsigned* sq_head;
+  unsigned* sq_tail;
+  unsigned* sq_array;
+  unsigned sq_mask;
+  unsigned sq_local_tail;
+
+  unsigned* cq_head;
+  unsigned* cq_tail;
+  struct io_uring_cqe* cqes;
+  unsigned cq_mask;
+
+  uint64_t next_tag;
+  std::map<uint64_t, uring_op> ops;
+
+  // the buffers of group 0, for recv with buffer selection
+  std::vector<char> pool;
+  unsigned pool_count;
+  unsigned pool_size;
+};
+
+static std::map<int, uring_state*> uring_states;
+
+/*
+ * unmaps the queues of the ring RING_FD, if it is one, and forgets it.
+ * The kernel may still write into the buffers of operations in flight
+ * until it has cancelled them, so their state is then left allocated.
+ */
+static void close_uring (int ring_fd)
+{
+  std::map<int, uring_state*>::iterator it = uring_states.find (ring_fd);
+  if (it == uring_states.end ())
+    return;
+
+  uring_state* st = it->second;
+  munmap (st->sqes, st->sqes_size);
+  if (st->cq_ring != st->sq_ring)
+    munmap (st->cq_ring, st->cq_ring_size);
+  munmap (st->sq_ring, st->sq_ring_size);
+  if (st->ops.empty ())
+    delete st;
+  uring_states.erase (it);
+}
+#endif
+
+#if defined (__linux__) && defined (MFD_CLOEXEC)
+/*
+ * state of a shared memory channel, see shm_channel_create.
+ */
+struct shm_channel
+{
+  int sock;
+  bool writer;
+  char* ring;
+  size_t size;
+  // writer: the next free position, and the one up to which the reader
+  // is done, with a partially received answer in ACK
+  uint64_t head;
+  uint64_t tail;
+  unsigned char ack[8];
+  size_t ack_len;
+};
+
+static std::map<int, shm_channel> shm_channels;
+static int next_shm_channel = 1;
+
+/*
+ * unmaps and forgets the shared memory channels over socket SOCK_FD.
+ */
+static void close_shm_channels (int sock_fd)
+{
+  std::map<int, shm_channel>::iterator it = shm_channels.begin ();
+  while (it != shm_channels.end ())
+    {
+      if (it->second.sock == sock_fd)
+        {
+          munmap (it->second.ring, it->second.size);
+          shm_channels.erase (it++);
+        }
+      else
+        it++;
+    }
+}
+#endif
+
+class octave_socket;
+static std::map<int, octave_socket*> socket_objects;
+
+/*
+ * closes the given socket file descriptor, and forgets the state and
+ * the octave_socket object kept for it.
+ */
+static void close_octavesocket (const int sock_fd);
+
+/*
+ * A socket as an octave value.  It owns its descriptor and closes it
+ * when the last copy of the value is cleared, unless disconnect has
+ * closed it before.  Otherwise it is the double scalar holding its
+ * descriptor, so sockets can be used in arithmetic and comparisons and
+ * concatenated into arrays of descriptors, as when they were plain
+ * integers.  Such arrays and other values computed from a socket do
+ * not own the descriptor.  Functions taking sockets accept either this
+ * type or a plain integer descriptor.
+ */
+class octave_socket : public octave_scalar
+{
+public:
+
+  octave_socket (int fd = -1, int domain = AF_INET, int type = SOCK_STREAM,
+                 int protocol = 0)
+    : octave_scalar (fd), sock_fd (fd), sock_domain (domain),
+      sock_type (type), sock_protocol (protocol)
+  {
+    // The descriptor is new, so state kept for a closed socket with the
+    // same number is stale
+    if (sock_fd >= 0)
+      {
+        socket_objects[sock_fd] = this;
+        socket_states.erase (sock_fd);
+        stale_sockets.erase (sock_fd);
+      }
+  }
+
+  ~octave_socket ()
+  {
+    if (sock_fd >= 0)
+      close_octavesocket (sock_fd);
+  }
+
+  int fd () const { return sock_fd; }
+  int domain () const { return sock_domain; }
+  int type () const { return sock_type; }
+  int protocol () const { return sock_protocol; }
+
+  // called by close_octavesocket
+  void closed ()
+  {
+    sock_fd = -1;
+    scalar = -1;
+  }
+
+  // copies made to be modified are plain scalars
+  octave_base_value* clone () const { return new octave_scalar (scalar); }
+
+  // operators are those of the scalar
+  type_conv_info numeric_conversion_function () const;
+
+  void print_raw (std::ostream& os, bool = false) const;
+
+private:
+
+  int sock_fd;
+  int sock_domain;
+  int sock_type;
+  int sock_protocol;
+
+  DECLARE_OV_TYPEID_FUNCTIONS_AND_DATA
+};
+
+DEFINE_OV_TYPEID_FUNCTIONS_AND_DATA (octave_socket, "octave_socket", "double");
+
+static octave_base_value*
+socket_numeric_conversion_function (const octave_base_value& a)
+{
+  const octave_socket& v = dynamic_cast<const octave_socket&> (a);
+  return new octave_scalar (v.fd ());
+}
+
+octave_base_value::type_conv_info
+octave_socket::numeric_conversion_function () const
+{
+  return octave_base_value::type_conv_info
+           (socket_numeric_conversion_function,
+            octave_scalar::static_type_id ());
+}
+
+/*
+ * helper functions returning the name of a socket domain or type
+ * constant, for display.
+ */
+static std::string socket_domain_name (int domain)
+{
+  switch (domain)
+    {
+    case AF_INET:
+      return "AF_INET";
+    case AF_INET6:
+      return "AF_INET6";
+    case AF_UNIX:
+      return "AF_UNIX";
+    default:
+      return "unknown domain";
+    }
+}
+
+static std::string socket_type_name (int type)
+{
+  switch (type)
+    {
+    case SOCK_STREAM:
+      return "SOCK_STREAM";
+    case SOCK_DGRAM:
+      return "SOCK_DGRAM";
+    case SOCK_SEQPACKET:
+      return "SOCK_SEQPACKET";
+    case SOCK_RAW:
+      return "SOCK_RAW";
+    default:
+      return "unknown type";
+    }
+}
+
+void octave_socket::print_raw (std::ostream& os, bool) const
+{
+  indent (os);
+  if (sock_fd < 0)
+    os << "socket (closed)";
+  else
+    os << "socket " << sock_fd << " (" << socket_domain_name (sock_domain)
+       << ", " << socket_type_name (sock_type) << ")";
+}
+
+static void close_octavesocket (const int sock_fd) {
+  std::map<int, octave_socket*>::iterator it = socket_objects.find (sock_fd);
+  if (it != socket_objects.end ())
+    {
+      it->second->closed ();
+      socket_objects.erase (it);
+    }
+  socket_states.erase (sock_fd);
+#ifndef __WIN32__
+  stop_async_reader (sock_fd);
+#ifdef HAVE_IO_URING
+  close_uring (sock_fd);
+#endif
+#if defined (__linux__) && defined (MFD_CLOEXEC)
+  close_shm_channels (sock_fd);
+#endif
+  ::close (sock_fd);
+#else
+  ::closesocket (sock_fd);
+#endif
+}
+
+/*
+ * helper function to convert an octave value, either an octave_socket
+ * or an integer, to a socket descriptor, returning -1 if it failed.
+ * First drops the state of the sockets found not to be open since.
+ */
+int get_socket(const octave_value& arg)
+{
+  for (std::set<int>::const_iterator it = stale_sockets.begin ();
+       it != stale_sockets.end (); it++)
+    socket_states.erase (*it);
+  stale_sockets.clear ();
+
+  if (arg.type_id () == octave_socket::static_type_id ())
+    return dynamic_cast<const octave_socket&> (arg.get_rep ()).fd ();
+
+  const int fd = arg.int_value();
+  if (error_state)
+    {
+      return -1;
+    }
+  return fd;
+}
+
+/*
+ * helper function to convert an array or a cell array of sockets to
+ * their descriptors.  Sets error_state if it failed.
+ */
+static Array<int> get_socket_array (const octave_value& arg)
+{
+  if (! arg.is_cell ())
+    return arg.int_vector_value ();
+
+  const Cell c = arg.cell_value ();
+  Array<int> fds (dim_vector (c.numel (), 1));
+  for (octave_idx_type i = 0; i < c.numel () && ! error_state; i++)
+    fds(i) = get_socket (c(i));
+  return fds;
+}
+
+//we need to keep track if sockets has been loaded, as the octave_socket
+//type must be registered once, and it requires initialization on
+//windows platforms.
+static bool type_loaded = false;
+
+/*
+ * helper function to do the initialization above.  Returns false and
+ * sets error_state if it failed.
+ */
+static bool load_socket_type (const char* who)
+{
+  if (type_loaded)
+    return true;
+
+#ifdef __WIN32__
+  WORD wVersionRequested;
+  WSADATA wsaData;
+  int err;
+
+  wVersionRequested = MAKEWORD (2, 2);
+  err = WSAStartup (wVersionRequested, &wsaData);
+  if (err != 0)
+    {
+      error ("%s: could not initialize winsock library", who);
+      return false;
+    }
+#endif
+
+  octave_socket::register_type ();
+  // octave_socket values must not outlive the code of this file
+  mlock ();
+
+  type_loaded = true;
+  return true;
+}
+
+// PKG_ADD: autoload ("socket", which ("socket"));
+// PKG_DEL: try; autoload ("socket", which ("socket"), "remove"); catch; end;
+// Function to create a socket
+DEFUN_DLD(socket, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {} socket ()\n\
+@deftypefnx {Loadable Function} {} socket (@var{domain})\n\
+@deftypefnx {Loadable Function} {} socket (@var{domain}, @var{type})\n\
+@deftypefnx {Loadable Function} {} socket (@var{domain}, @var{type}, @var{protocol})\n\
+Creates a socket.\n\
+\n\
+@var{domain} is an integer, where the value AF_INET\n\
+can be used to create an IPv4 socket, and AF_INET6 an IPv6 one.  An\n\
+AF_INET6 socket can also reach IPv4 hosts, through v4-mapped\n\
+addresses, unless the option IPV6_V6ONLY is set.\n\
+AF_UNIX creates a socket for local communication, bound and connected\n\
+to a path instead of an address and port.\n\
+\n\
+@var{type} is an integer describing the socket.  When using IP, specifying\n\
+SOCK_STREAM gives a TCP socket.\n\
+\n\
+@var{protocol} is currently not used and should be 0 if specified.\n\
+\n\
+If no input arguments are given, default values AF_INET and\n\
+SOCK_STREAM are used.\n\
+\n\
+The socket is returned as a double scalar holding its descriptor,\n\
+which can be used in arithmetic and comparisons and concatenated into\n\
+arrays of descriptors like a plain integer.  It also owns the\n\
+descriptor: the socket is closed when the last variable holding it is\n\
+cleared, if @code{disconnect} has not closed it before.  Arrays and\n\
+other values computed from it do not keep it open.  Use\n\
+@code{socket_info} to see its properties.\n\
+\n\
+See the local @command{socket} reference for more details.\n\
+@end deftypefn")
+{
+  int domain    = AF_INET;
+  int type      = SOCK_STREAM;
+  int protocol  = 0;
+
+  if (! load_socket_type ("socket"))
+    return octave_value ();
+
+  // Convert the arguments to their #define'd value
+  const octave_idx_type nargin = args.length ();
+  if (nargin > 0)
+    {
+      domain = args(0).int_value ();
+      if (error_state)
+        {
+          error ("socket: DOMAIN must be a scalar integer");
+          return octave_value ();
+        }
+    }
+
+  if (nargin > 1)
+    {
+      type = args(1).int_value ();
+      if (error_state)
+        {
+          error ("socket: TYPE must be a scalar integer");
+          return octave_value ();
+        }
+    }
+
+  if (nargin > 2)
+    {
+      protocol = args(2).int_value ();
+      if (error_state)
+        {
+          error ("socket: PROTOCOL must be a scalar integer");
+          return octave_value ();
+        }
+      else if (protocol != 0)
+      {
+        error ("socket: for now, PROTOCOL must always be 0 (zero)");
+        return octave_value ();
+      }
+    }
+
+  // Create the new socket
+  const int sock_fd = ::socket (domain, type, protocol);
+  if (sock_fd == -1)
+    {
+      error ("socket failed with error %i (%s)", errno, strerror(errno));
+      return octave_value (sock_fd);
+    }
+
+  return octave_value (new octave_socket (sock_fd, domain, type, protocol));
+}
+
+// PKG_ADD: autoload ("socketpair", which ("socket"));
+// PKG_DEL: try; autoload ("socketpair", which ("socket"), "remove"); catch; end;
+// function to create a pair of connected sockets
+#ifndef __WIN32__
+DEFUN_DLD(socketpair, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {[@var{s1}, @var{s2}] =} socketpair ()\n\
+@deftypefnx {Loadable Function} {[@var{s1}, @var{s2}] =} socketpair (@var{domain})\n\
+@deftypefnx {Loadable Function} {[@var{s1}, @var{s2}] =} socketpair (@var{domain}, @var{type})\n\
+Creates a pair of connected sockets.\n\
+\n\
+Returns two sockets connected to each other, owning their descriptors\n\
+like the ones of @code{socket}.  @var{domain} must be AF_UNIX, the default.\n\
+@var{type} is SOCK_STREAM, the default, SOCK_DGRAM or SOCK_SEQPACKET.\n\
+Data written to one socket is read from the other without going\n\
+through the network stack, for example between octave and a process\n\
+started with one of the sockets.\n\
+\n\
+See the @command{socketpair} man pages for further details.\n\
+@seealso{socket}\n\
+@end deftypefn")
+{
+  const octave_idx_type nargin = args.length ();
+  if (nargin > 2)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  int domain = AF_UNIX;
+  int type = SOCK_STREAM;
+  if (nargin > 0)
+    {
+      domain = args(0).int_value ();
+      if (error_state)
+        {
+          error ("socketpair: DOMAIN must be a scalar integer");
+          return octave_value ();
+        }
+    }
+  if (nargin > 1)
+    {
+      type = args(1).int_value ();
+      if (error_state)
+        {
+          error ("socketpair: TYPE must be a scalar integer");
+          return octave_value ();
+        }
+    }
+
+  if (! load_socket_type ("socketpair"))
+    return octave_value ();
+
+  int fds[2];
+  if (::socketpair (domain, type, 0, fds) == -1)
+    {
+      error ("socketpair failed with error %i (%s)", errno, strerror(errno));
+      return octave_value ();
+    }
+
+  octave_value_list return_list;
+  return_list(0) = octave_value (new octave_socket (fds[0], domain, type, 0));
+  return_list(1) = octave_value (new octave_socket (fds[1], domain, type, 0));
+  return return_list;
+}
+#else
+DEFUNX_DLD ("socketpair", Fsocketpair, Gsocketpair, args, nargout, "(not supported)")
+{ error( "socketpair: not supported on this platform" );
+  return octave_value(); };
+#endif
+
+/*
+ * The resolver.  Host names are looked up with getaddrinfo, and the
+ * results, including failures, are kept for a while so that connecting
+ * again and again to the same host does not query the name service
+ * every time.
+ */
+struct resolved_addr
+{
+  int family;
+  int socktype;
+  int protocol;
+  struct sockaddr_storage sa;
+  socklen_t salen;
+};
+
+struct resolver_entry
+{
+  // monotonic time after which the entry is stale
+  double expires;
+  // the getaddrinfo error, 0 on success
+  int err;
+  std::vector<resolved_addr> addrs;
+};
+
+static std::map<std::string, resolver_entry> resolver_cache;
+static double resolver_ttl = 60;
+static double resolver_negative_ttl = 5;
+
+// no more entries than this are kept, to bound the memory used
+static const size_t resolver_max_entries = 4096;
+
+static double resolver_hits = 0;
+static double resolver_negative_hits = 0;
+static double resolver_lookups = 0;
+static double resolver_failures = 0;
+
+/*
+ * helper function to look up HOST, restricted to the address FAMILY if
+ * it is not AF_UNSPEC.  Returns the cached or new entry.  An entry that
+ * is not cached because its time to live is 0 is only valid until the
+ * next call.
+ */
+static const resolver_entry& resolve_host (const std::string& host,
+                                           int family)
+{
+  std::ostringstream key;
+  key << family << ':' << host;
+
+  const double now = monotonic_time ();
+  std::map<std::string, resolver_entry>::iterator it
+    = resolver_cache.find (key.str ());
+  if (it != resolver_cache.end () && it->second.expires > now)
+    {
+      if (it->second.err)
+        resolver_negative_hits++;
+      else
+        resolver_hits++;
+      return it->second;
+    }
+
+  struct addrinfo hints;
+  memset (&hints, 0, sizeof (hints));
+  hints.ai_family = family;
+  struct addrinfo* res = 0;
+  resolver_lookups++;
+  const int err = getaddrinfo (host.c_str (), 0, &hints, &res);
+
+  static resolver_entry uncached;
+  const double ttl = (err ? resolver_negative_ttl : resolver_ttl);
+  resolver_entry* entry_ptr = &uncached;
+  if (ttl > 0)
+    {
+      if (resolver_cache.size () >= resolver_max_entries)
+        {
+          for (std::map<std::string, resolver_entry>::iterator jt
+                 = resolver_cache.begin (); jt != resolver_cache.end (); )
+            {
+              if (jt->second.expires <= now)
+                resolver_cache.erase (jt++);
+              else
+                jt++;
+            }
+          if (resolver_cache.size () >= resolver_max_entries)
+            resolver_cache.clear ();
+        }
+      entry_ptr = &resolver_cache[key.str ()];
+    }
+  else if (it != resolver_cache.end ())
+    resolver_cache.erase (it);
+
+  resolver_entry& entry = *entry_ptr;
+  entry.err = err;
+  entry.addrs.clear ();
+  entry.expires = now + ttl;
+  if (err)
+    resolver_failures++;
+  else
+    {
+      for (struct addrinfo* ai = res; ai; ai = ai->ai_next)
+        {
+          if (ai->ai_addrlen > sizeof (struct sockaddr_storage))
+            continue;
+          resolved_addr a;
+          memset (&a, 0, sizeof (a));
+          a.family = ai->ai_family;
+          a.socktype = ai->ai_socktype;
+          a.protocol = ai->ai_protocol;
+          memcpy (&a.sa, ai->ai_addr, ai->ai_addrlen);
+          a.salen = ai->ai_addrlen;
+          entry.addrs.push_back (a);
+        }
+      freeaddrinfo (res);
+    }
+  return entry;
+}
+
+/*
+ * helper function to format the address of SA numerically.
+ */
+static std::string sockaddr_to_string (const struct sockaddr* sa,
+                                       socklen_t salen)
+{
+  char host[NI_MAXHOST];
+  if (getnameinfo (sa, salen, host, sizeof (host), 0, 0, NI_NUMERICHOST) != 0)
+    return "";
+  return host;
+}
+
+/*
+ * helper function returning the address family of socket S, AF_INET if
+ * it can not be determined.
+ */
+static int socket_family (int s)
+{
+  struct sockaddr_storage sa;
+  socklen_t len = sizeof (sa);
+  memset (&sa, 0, sizeof (sa));
+#ifndef __WIN32__
+  if (getsockname (s, (struct sockaddr*)&sa, &len) == -1)
+#else
+  if (getsockname (s, (struct sockaddr*)&sa, (int*)&len) == -1)
+#endif
+    return AF_INET;
+#ifndef __WIN32__
+  if (sa.ss_family == AF_UNIX)
+    return AF_UNIX;
+#endif
+  return sa.ss_family == AF_INET6 ? AF_INET6 : AF_INET;
+}
+
+#ifndef __WIN32__
+/*
+ * helper function to fill SA with the AF_UNIX address given by ARG,
+ * either a path or a struct with the path in the field "addr".  A path
+ * starting with "@" or a NUL character names a socket in the abstract
+ * namespace of Linux.  Returns the length of the address, or 0 and
+ * sets error_state on failure.
+ */
+static socklen_t get_unix_sockaddr (const octave_value& arg,
+                                    struct sockaddr_storage& sa,
+                                    const char* who, const char* name)
+{
+  std::string path;
+  if (arg.is_string ())
+    path = arg.string_value ();
+  else if (arg.is_map ())
+    path = arg.scalar_map_value ().getfield ("addr").string_value ();
+  if (error_state || path.empty ())
+    {
+      error ("%s: %s must be a path or a struct with a path in field \"addr\"",
+             who, name);
+      return 0;
+    }
+
+  memset (&sa, 0, sizeof (sa));
+  struct sockaddr_un* sun = reinterpret_cast<struct sockaddr_un*> (&sa);
+  sun->sun_family = AF_UNIX;
+  const bool abstract = (path[0] == '@' || path[0] == '\0');
+  if (path.size () + (abstract ? 0 : 1) > sizeof (sun->sun_path)
+      || path.find ('\0', 1) != std::string::npos)
+    {
+      error ("%s: %s path \"%s\" is too long or contains a NUL character",
+             who, name, path.c_str ());
+      return 0;
+    }
+
+  memcpy (sun->sun_path, path.data (), path.size ());
+  if (abstract)
+    sun->sun_path[0] = '\0';
+  return offsetof (struct sockaddr_un, sun_path) + path.size ()
+    + (abstract ? 0 : 1);
+}
+#endif
+
+/*
+ * helper function returning the type of socket S, SOCK_STREAM if it can
+ * not be determined.  Sockets accepted on S have the same type.
+ */
+static int socket_type (int s)
+{
+  int type = SOCK_STREAM;
+  socklen_t len = sizeof (type);
+#ifndef __WIN32__
+  getsockopt (s, SOL_SOCKET, SO_TYPE, &type, &len);
+#else
+  getsockopt (s, SOL_SOCKET, SO_TYPE, (char*)&type, (int*)&len);
+#endif
+  return type;
+}
+
+/*
+ * helper function to fill SA from a struct with the fields "addr" and
+ * "port", as used by connect and sendto, for a socket of address
+ * FAMILY.  Host names are resolved to an IPv6 address for AF_INET6
+ * sockets if there is one, and to a v4-mapped address otherwise.  NAME
+ * is the name of the argument for error messages.  Returns the length
+ * of the address, or 0 and sets error_state on failure.
+ */
+static socklen_t get_sockaddr (const octave_value& arg, int family,
+                               struct sockaddr_storage& sa,
+                               const char* who, const char* name)
+{
+#ifndef __WIN32__
+  if (family == AF_UNIX)
+    return get_unix_sockaddr (arg, sa, who, name);
+#endif
+
+  const octave_scalar_map info = arg.scalar_map_value ();
+  if (error_state)
+    {
+      error ("%s: %s must be a struct", who, name);
+      return 0;
+    }
+
+  const std::string addr = info.getfield ("addr").string_value ();
+  const int port    = info.getfield ("port").int_value ();
+  if (error_state)
+    {
+      error ("%s: %s must have a string and integer in fields \"addr\" and \"port\"",
+             who, name);
+      return 0;
+    }
+  else if (addr.empty ())
+    {
+      error ("%s: %s addr is an empty string", who, name);
+      return 0;
+    }
+
+  memset (&sa, 0, sizeof (sa));
+  if (family == AF_INET6)
+    {
+      struct sockaddr_in6* sin6 = reinterpret_cast<struct sockaddr_in6*> (&sa);
+      sin6->sin6_family = AF_INET6;
+      sin6->sin6_port = htons (port);
+
+      const resolver_entry* entry = &resolve_host (addr, AF_INET6);
+      if (entry->err || entry->addrs.empty ())
+        entry = &resolve_host (addr, AF_INET);
+      if (entry->err || entry->addrs.empty ())
+        {
+          error ("%s: could not resolve \"%s\" (%s)", who, addr.c_str (),
+                 entry->err ? gai_strerror (entry->err) : "no address");
+          return 0;
+        }
+
+      const resolved_addr& found = entry->addrs[0];
+      if (found.family == AF_INET6)
+        {
+          const struct sockaddr_in6* a
+            = reinterpret_cast<const struct sockaddr_in6*> (&found.sa);
+          sin6->sin6_addr = a->sin6_addr;
+          sin6->sin6_scope_id = a->sin6_scope_id;
+        }
+      else
+        {
+          const struct sockaddr_in* a
+            = reinterpret_cast<const struct sockaddr_in*> (&found.sa);
+          unsigned char* b = sin6->sin6_addr.s6_addr;
+          b[10] = b[11] = 0xff;
+          memcpy (b + 12, &a->sin_addr, 4);
+        }
+      return sizeof (struct sockaddr_in6);
+    }
+
+  struct sockaddr_in* sin = reinterpret_cast<struct sockaddr_in*> (&sa);
+  sin->sin_family = AF_INET;
+  sin->sin_port = htons (port);
+
+  // Numeric addresses don't need a lookup
+  sin->sin_addr.s_addr = inet_addr (addr.c_str ());
+  if (sin->sin_addr.s_addr == INADDR_NONE && addr != "255.255.255.255")
+    {
+      const resolver_entry& entry = resolve_host (addr, AF_INET);
+      if (entry.err || entry.addrs.empty ())
+        {
+          error ("%s: could not resolve \"%s\" (%s)", who, addr.c_str (),
+                 entry.err ? gai_strerror (entry.err) : "no address");
+          return 0;
+        }
+      const struct sockaddr_in* found
+        = reinterpret_cast<const struct sockaddr_in*> (&entry.addrs[0].sa);
+      sin->sin_addr = found->sin_addr;
+    }
+  return sizeof (struct sockaddr_in);
+}
+
+/*
+ * helper function to fill SA with the wildcard address of FAMILY and
+ * PORT.  Returns the length of the address.
+ */
+static socklen_t any_sockaddr (int family, int port,
+                               struct sockaddr_storage& sa)
+{
+  memset (&sa, 0, sizeof (sa));
+  if (family == AF_INET6)
+    {
+      struct sockaddr_in6* sin6 = reinterpret_cast<struct sockaddr_in6*> (&sa);
+      sin6->sin6_family = AF_INET6;
+      sin6->sin6_port = htons (port);
+      sin6->sin6_addr = in6addr_any;
+      return sizeof (struct sockaddr_in6);
+    }
+
+  struct sockaddr_in* sin = reinterpret_cast<struct sockaddr_in*> (&sa);
+  sin->sin_family = AF_INET;
+  sin->sin_port = htons (port);
+  sin->sin_addr.s_addr = INADDR_ANY;
+  return sizeof (struct sockaddr_in);
+}
+
+/*
+ * helper function returning the length of the address SA.
+ */
+static socklen_t sockaddr_len (const struct sockaddr_storage& sa)
+{
+#ifndef __WIN32__
+  // Abstract names start with a NUL, and end at the next one here
+  if (sa.ss_family == AF_UNIX)
+    {
+      const struct sockaddr_un* sun
+        = reinterpret_cast<const struct sockaddr_un*> (&sa);
+      const size_t max = sizeof (sun->sun_path);
+      const size_t n = sun->sun_path[0]
+        ? std::min (strnlen (sun->sun_path, max) + 1, max)
+        : 1 + strnlen (sun->sun_path + 1, max - 1);
+      return offsetof (struct sockaddr_un, sun_path) + n;
+    }
+#endif
+  return sa.ss_family == AF_INET6 ? sizeof (struct sockaddr_in6)
+                                  : sizeof (struct sockaddr_in);
+}
+
+/*
+ * helper function returning the port of the address SA in host order.
+ */
+static int sockaddr_port (const struct sockaddr_storage& sa)
+{
+  if (sa.ss_family == AF_INET6)
+    return ntohs (reinterpret_cast<const struct sockaddr_in6*> (&sa)->sin6_port);
+  else if (sa.ss_family == AF_INET)
+    return ntohs (reinterpret_cast<const struct sockaddr_in*> (&sa)->sin_port);
+  return 0;
+}
+
+#ifndef __WIN32__
+/*
+ * helper function returning the path of the AF_UNIX address SA, with
+ * abstract names written as "@name".  Unnamed sockets give "".
+ */
+static std::string unix_path (const struct sockaddr_storage& sa)
+{
+  const struct sockaddr_un* sun
+    = reinterpret_cast<const struct sockaddr_un*> (&sa);
+  const size_t n = sockaddr_len (sa) - offsetof (struct sockaddr_un, sun_path);
+  if (sun->sun_path[0])
+    return std::string (sun->sun_path, n - 1);
+  else if (n > 1)
+    return "@" + std::string (sun->sun_path + 1, n - 1);
+  return "";
+}
+#endif
+
+/*
+ * helper function to convert SA to a struct with the fields "addr" and
+ * "port", which can be passed back to connect and sendto.  For AF_UNIX,
+ * addr is the path and port is 0.
+ */
+static octave_scalar_map sockaddr_to_map (const struct sockaddr_storage& sa)
+{
+  octave_scalar_map info;
+#ifndef __WIN32__
+  if (sa.ss_family == AF_UNIX)
+    {
+      info.assign ("addr", octave_value (unix_path (sa)));
+      info.assign ("port", octave_value (0));
+      return info;
+    }
+#endif
+  info.assign ("addr", octave_value (sockaddr_to_string
+                                     ((const struct sockaddr*)&sa,
+                                      sockaddr_len (sa))));
+  info.assign ("port", octave_value (sockaddr_port (sa)));
+  return info;
+}
+
+// PKG_ADD: autoload ("disconnect", which ("socket"));
+// PKG_DEL: try ; autoload ("disconnect", which ("socket"), "remove") ; catch ; end;
+// function to disconnect asocket
+DEFUN_DLD(disconnect, args, , "\
+-*- texinfo -*-\n\
+@deftypefn {Loadable Function} {} disconnect (@var{s})\n\
+Disconnect socket.\n\
+\n\
+Disconnects the socket @var{s}.  If successful, @code{disconnect} returns 0,\n\
+otherwise, it returns -1.\n\
+\n\
+Since we can't call fclose on the file descriptor directly, use this\n\
+function to disconnect the socket.\n\
+\n\
+@end deftypefn")
+{
+  if (args.length () != 1)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  int retval = -1;
+  const int s = get_socket (args(0));
+  if (! error_state)
+    {
+      close_octavesocket(s);
+      retval = 0;
+    }
+  return octave_value (retval);
+}
+
+// PKG_ADD: autoload ("socket_info", which ("socket"));
+// PKG_DEL: try; autoload ("socket_info", which ("socket"), "remove"); catch; end;
+// function to describe a socket
+DEFUN_DLD(socket_info, args, , "\
+-*- texinfo -*-\n\
+@deftypefn {Loadable Function} {@var{info} =} socket_info (@var{s})\n\
+Return information about a socket.\n\
+\n\
+Returns a struct describing the socket @var{s} with the fields:\n\
+\n\
+@table @code\n\
+@item fd\n\
+the descriptor of the socket\n\
+\n\
+@item open\n\
+true, unless @code{disconnect} closed the socket\n\
+\n\
+@item family\n\
+@itemx type\n\
+@itemx protocol\n\
+the values given to @code{socket}, or -1 if unknown\n\
+\n\
+@item local\n\
+@itemx peer\n\
+structs with the fields @code{addr} and @code{port} of the local and\n\
+the remote end, or empty if not known.  For AF_UNIX sockets @code{addr}\n\
+is the path, empty if unnamed, and @code{port} is 0\n\
+\n\
+@item bytes_sent\n\
+@itemx bytes_received\n\
+the number of bytes transferred by the functions of this package\n\
+@end table\n\
+\n\
+@var{s} may also be a plain integer descriptor.\n\
+@end deftypefn")
+{
+  if (args.length () != 1)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  const int s = get_socket (args(0));
+  if (error_state)
+    {
+      error ("socket_info: S must be a valid socket");
+      return octave_value ();
+    }
+
+  int family = -1;
+  int type = -1;
+  int protocol = -1;
+  bool open = true;
+  if (args(0).type_id () == octave_socket::static_type_id ())
+    {
+      const octave_socket& obj
+        = dynamic_cast<const octave_socket&> (args(0).get_rep ());
+      family = obj.domain ();
+      type = obj.type ();
+      protocol = obj.protocol ();
+      open = (obj.fd () >= 0);
+    }
+
+  octave_scalar_map info;
+  info.assign ("fd", octave_value (s));
+  info.assign ("open", octave_value (open));
+  info.assign ("family", octave_value (family));
+  info.assign ("type", octave_value (type));
+  info.assign ("protocol", octave_value (protocol));
+
+  octave_value local = Matrix ();
+  octave_value peer = Matrix ();
+  if (open && s >= 0)
+    {
+      struct sockaddr_storage sa;
+      memset (&sa, 0, sizeof (sa));
+      socklen_t len = sizeof (sa);
+#ifndef __WIN32__
+      if (getsockname (s, (struct sockaddr*)&sa, &len) == 0
+#else
+      if (getsockname (s, (struct sockaddr*)&sa, (int*)&len) == 0
+#endif
+          && sa.ss_family != AF_UNSPEC)
+        local = sockaddr_to_map (sa);
+
+      memset (&sa, 0, sizeof (sa));
+      len = sizeof (sa);
+#ifndef __WIN32__
+      if (getpeername (s, (struct sockaddr*)&sa, &len) == 0
+#else
+      if (getpeername (s, (struct sockaddr*)&sa, (int*)&len) == 0
+#endif
+          && sa.ss_family != AF_UNSPEC)
+        peer = sockaddr_to_map (sa);
+    }
+
+  double bytes_sent = 0;
+  double bytes_received = 0;
+  std::map<int, socket_state>::const_iterator it = socket_states.find (s);
+  if (it != socket_states.end ())
+    {
+      // connected datagram sockets and closed sockets have no peer name
+      if (peer.is_empty () && it->second.have_peer)
+        peer = sockaddr_to_map (it->second.peer);
+      bytes_sent = it->second.stats.bytes_sent;
+      bytes_received = it->second.stats.bytes_received;
+    }
+
+  info.assign ("local", local);
+  info.assign ("peer", peer);
+  info.assign ("bytes_sent", octave_value (bytes_sent));
+  info.assign ("bytes_received", octave_value (bytes_received));
+
+  return octave_value (info);
+}
+
+/*
+ * helper function to convert the TCP_INFO of socket S to a struct.
+ * Returns an empty matrix if S is not a TCP socket or TCP_INFO is not
+ * available on this platform.
+ */
+static octave_value get_tcp_info (int s)
+{
+#if defined (__linux__) && defined (TCP_INFO)
+  struct tcp_info ti;
+  socklen_t len = sizeof (ti);
+  memset (&ti, 0, sizeof (ti));
+  if (getsockopt (s, IPPROTO_TCP, TCP_INFO, &ti, &len) == -1)
+    return octave_value (Matrix ());
+
+  octave_scalar_map info;
+  info.assign ("state", octave_value (int (ti.tcpi_state)));
+  info.assign ("rtt", octave_value (ti.tcpi_rtt * 1e-6));
+  info.assign ("rttvar", octave_value (ti.tcpi_rttvar * 1e-6));
+  info.assign ("rto", octave_value (ti.tcpi_rto * 1e-6));
+  info.assign ("snd_cwnd", octave_value (double (ti.tcpi_snd_cwnd)));
+  info.assign ("snd_ssthresh", octave_value (double (ti.tcpi_snd_ssthresh)));
+  info.assign ("snd_mss", octave_value (double (ti.tcpi_snd_mss)));
+  info.assign ("unacked", octave_value (double (ti.tcpi_unacked)));
+  info.assign ("lost", octave_value (double (ti.tcpi_lost)));
+  info.assign ("retransmits", octave_value (int (ti.tcpi_retransmits)));
+  info.assign ("total_retrans", octave_value (double (ti.tcpi_total_retrans)));
+  return octave_value (info);
+#else
+  return octave_value (Matrix ());
+#endif
+}
+
+/*
+ * helper function to convert the counters ST to a struct.
+ */
+static octave_scalar_map io_stats_to_map (const io_stats& st)
+{
+  octave_scalar_map stats;
+  stats.assign ("enabled", octave_value (io_stats_enabled));
+  stats.assign ("bytes_sent", octave_value (st.bytes_sent));
+  stats.assign ("bytes_received", octave_value (st.bytes_received));
+
+  RowVector edges (io_hist_buckets);
+  edges(0) = 0;
+  for (int i = 1; i < io_hist_buckets; i++)
+    edges(i) = ldexp (1e-6, i - 1);
+
+  for (int k = 0; k < IO_KINDS; k++)
+    {
+      const std::string name = io_kind_names[k];
+      RowVector hist (io_hist_buckets);
+      for (int i = 0; i < io_hist_buckets; i++)
+        hist(i) = st.hist[k][i];
+      stats.assign (name + "_calls", octave_value (st.calls[k]));
+      stats.assign (name + "_time", octave_value (st.time[k]));
+      stats.assign (name + "_hist", octave_value (hist));
+    }
+  stats.assign ("hist_edges", octave_value (edges));
+
+  stats.assign ("eagain", octave_value (st.eagain));
+  stats.assign ("eintr", octave_value (st.eintr));
+  stats.assign ("short_writes", octave_value (st.short_writes));
+  stats.assign ("short_reads", octave_value (st.short_reads));
+  stats.assign ("zerocopy_sends", octave_value (st.zerocopy_sends));
+  stats.assign ("zerocopy_completions", octave_value (st.zerocopy_completions));
+  stats.assign ("zerocopy_copied", octave_value (st.zerocopy_copied));
+  return stats;
+}
+
+// PKG_ADD: autoload ("socket_stats", which ("socket"));
+// PKG_DEL: try; autoload ("socket_stats", which ("socket"), "remove"); catch; end;
+// function to report I/O statistics
+DEFUN_DLD(socket_stats, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {@var{stats} =} socket_stats ()\n\
+@deftypefnx {Loadable Function} {@var{stats} =} socket_stats (@var{s})\n\
+@deftypefnx {Loadable Function} {@var{stats} =} socket_stats (@dots{}, \"reset\")\n\
+@deftypefnx {Loadable Function} {} socket_stats (\"enable\")\n\
+@deftypefnx {Loadable Function} {} socket_stats (\"disable\")\n\
+Return I/O statistics of a socket, or of all sockets.\n\
+\n\
+Statistics are only collected after @code{socket_stats (\"enable\")},\n\
+since timing every system call has a small cost.  Byte counters are\n\
+always kept.  Without @var{s}, the counters of all sockets since the\n\
+package was loaded are returned, otherwise those of socket @var{s}.\n\
+With \"reset\", the counters are cleared after being returned; without\n\
+@var{s}, those of every socket are.\n\
+\n\
+@var{stats} is a struct with the fields:\n\
+\n\
+@table @code\n\
+@item enabled\n\
+whether statistics are being collected\n\
+\n\
+@item bytes_sent\n\
+@itemx bytes_received\n\
+the number of bytes transferred\n\
+\n\
+@item send_calls\n\
+@itemx recv_calls\n\
+@itemx accept_calls\n\
+the number of system calls made to send, receive and accept\n\
+\n\
+@item send_time\n\
+@itemx recv_time\n\
+@itemx accept_time\n\
+the total time in seconds spent in these system calls\n\
+\n\
+@item send_hist\n\
+@itemx recv_hist\n\
+@itemx accept_hist\n\
+histograms of the time spent in each system call, counting the calls\n\
+that took at least the corresponding element of @code{hist_edges}\n\
+seconds, and less than the next one\n\
+\n\
+@item hist_edges\n\
+the lower edges of the histogram bins: 0, 1 microsecond and doubling\n\
+\n\
+@item eagain\n\
+@itemx eintr\n\
+the number of calls that would have blocked, or were interrupted\n\
+\n\
+@item short_writes\n\
+@itemx short_reads\n\
+the number of calls that transferred less than asked\n\
+\n\
+@item zerocopy_sends\n\
+@itemx zerocopy_completions\n\
+@itemx zerocopy_copied\n\
+the number of sends made with the @qcode{\"zerocopy\"} option of\n\
+@code{send}, of those the kernel has finished with, and of those for\n\
+which it had to copy the data after all\n\
+\n\
+@item tcp_info\n\
+for a TCP socket @var{s} on Linux, a struct with the fields\n\
+@code{state}, @code{rtt}, @code{rttvar} and @code{rto} (in seconds),\n\
+@code{snd_cwnd}, @code{snd_ssthresh}, @code{snd_mss}, @code{unacked},\n\
+@code{lost}, @code{retransmits} and @code{total_retrans} from the\n\
+kernel, otherwise empty\n\
+@end table\n\
+\n\
+Receiving in the background with @code{recv_async_start} is counted by\n\
+@code{recv_async_stats} instead.\n\
+@end deftypefn")
+{
+  const octave_idx_type nargin = args.length ();
+  if (nargin > 2)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  if (nargin == 1 && args(0).is_string ()
+      && args(0).string_value () != "reset")
+    {
+      const std::string cmd = args(0).string_value ();
+      if (cmd == "enable")
+        io_stats_enabled = true;
+      else if (cmd == "disable")
+        io_stats_enabled = false;
+      else
+        error ("socket_stats: unknown command \"%s\"", cmd.c_str ());
+      return octave_value ();
+    }
+
+  bool reset = false;
+  if (nargin > 0 && args(nargin-1).is_string ())
+    {
+      if (args(nargin-1).string_value () != "reset")
+        {
+          error ("socket_stats: the last argument must be \"reset\"");
+          return octave_value ();
+        }
+      reset = true;
+    }
+
+  const bool have_socket = nargin > (reset ? 1 : 0);
+  if (! have_socket)
+    {
+      const octave_scalar_map stats = io_stats_to_map (global_io_stats);
+      if (reset)
+        {
+          global_io_stats.reset ();
+          for (std::map<int, socket_state>::iterator it = socket_states.begin ();
+               it != socket_states.end (); it++)
+            it->second.stats.reset ();
+        }
+      return octave_value (stats);
+    }
+
+  const int s = get_socket (args(0));
+  if (error_state)
+    {
+      error ("socket_stats: S must be a valid socket");
+      return octave_value ();
+    }
+
+  // Sockets nothing was counted for yet have no state
+  io_stats none;
+  none.reset ();
+  std::map<int, socket_state>::iterator it = socket_states.find (s);
+  io_stats& st = (it == socket_states.end () ? none : it->second.stats);
+  octave_scalar_map stats = io_stats_to_map (st);
+  stats.assign ("tcp_info", get_tcp_info (s));
+  if (reset)
+    st.reset ();
+  return octave_value (stats);
+}
+
+// PKG_ADD: autoload ("gethostbyname", which ("socket"));
+// PKG_DEL: try; autoload ("gethostbyname", which ("socket"), "remove"); ; catch; end;
+// function to get a host number from a host name
+DEFUN_DLD(gethostbyname, args, , "\
+-*- texinfo -*-\n\
+@deftypefn {Loadable Function} {} gethostbyname (@var{hostname})\n\
+Return the IPv4 addresses for host name.\n\
+\n\
+All addresses of @var{hostname} are returned, one per row.  Host names\n\
+are resolved with @code{getaddrinfo} and cached, see @code{resolver_stats}.\n\
 For example:\n\
 \n\
-@example\n\
-@group\n\
-gethostbyname (\"localhost\")\n\
-  @result{} 127.0.0.1\n\
-@end group\n\
-@end example\n\
+@example\n\
+@group\n\
+gethostbyname (\"localhost\")\n\
+  @result{} 127.0.0.1\n\
+@end group\n\
+@end example\n\
+\n\
+See the @command{gethostbyname} man pages for details.\n\
+@seealso{getaddrinfo}\n\
+@end deftypefn")
+{
+  const int nargin = args.length ();
+
+  if (nargin != 1)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  const std::string addr = args(0).string_value ();
+  if (error_state)
+    {
+      error ("gethostbyname: HOSTNAME must be a string");
+      return octave_value ();
+    }
+
+  // getaddrinfo returns each address once per socket type
+  std::vector<std::string> addrs;
+  string_vector host_list;
+  const resolver_entry& entry = resolve_host (addr, AF_INET);
+  for (size_t i = 0; i < entry.addrs.size (); i++)
+    {
+      const resolved_addr& a = entry.addrs[i];
+      const std::string temp_addr
+        = sockaddr_to_string ((const struct sockaddr*)&a.sa, a.salen);
+      if (std::find (addrs.begin (), addrs.end (), temp_addr) == addrs.end ())
+        {
+          addrs.push_back (temp_addr);
+          host_list.append (temp_addr);
+        }
+    }
+  return octave_value (host_list);
+}
+
+// PKG_ADD: autoload ("getaddrinfo", which ("socket"));
+// PKG_DEL: try; autoload ("getaddrinfo", which ("socket"), "remove"); catch; end;
+// function to get all addresses of a host
+DEFUN_DLD(getaddrinfo, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {@var{info} =} getaddrinfo (@var{hostname})\n\
+@deftypefnx {Loadable Function} {@var{info} =} getaddrinfo (@var{hostname}, @var{family})\n\
+Return all addresses for host name.\n\
+\n\
+Returns a struct array with one element per address of @var{hostname}\n\
+and socket type, with the fields @code{addr}, @code{family},\n\
+@code{socktype} and @code{protocol}.  @var{family} restricts the\n\
+addresses to one family, such as AF_INET.  The @code{addr} field can be\n\
+used in the struct given to @code{connect}.\n\
+\n\
+Results, and failures, are cached, see @code{resolver_stats}.  It is an\n\
+error if @var{hostname} can not be resolved.\n\
+\n\
+See the @command{getaddrinfo} man pages for details.\n\
+@seealso{gethostbyname, resolver_stats, resolver_flush}\n\
+@end deftypefn")
+{
+  const octave_idx_type nargin = args.length ();
+  if (nargin != 1 && nargin != 2)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  const std::string host = args(0).string_value ();
+  if (error_state)
+    {
+      error ("getaddrinfo: HOSTNAME must be a string");
+      return octave_value ();
+    }
+
+  int family = AF_UNSPEC;
+  if (nargin > 1)
+    {
+      family = args(1).int_value ();
+      if (error_state)
+        {
+          error ("getaddrinfo: FAMILY must be a scalar integer");
+          return octave_value ();
+        }
+    }
+
+  const resolver_entry& entry = resolve_host (host, family);
+  if (entry.err)
+    {
+      error ("getaddrinfo: could not resolve \"%s\" (%s)", host.c_str (),
+             gai_strerror (entry.err));
+      return octave_value ();
+    }
+
+  const octave_idx_type n = entry.addrs.size ();
+  Cell addr (dim_vector (n, 1));
+  Cell fam (dim_vector (n, 1));
+  Cell socktype (dim_vector (n, 1));
+  Cell protocol (dim_vector (n, 1));
+  for (octave_idx_type i = 0; i < n; i++)
+    {
+      const resolved_addr& a = entry.addrs[i];
+      addr(i) = sockaddr_to_string ((const struct sockaddr*)&a.sa, a.salen);
+      fam(i) = a.family;
+      socktype(i) = a.socktype;
+      protocol(i) = a.protocol;
+    }
+
+  octave_map info (dim_vector (n, 1));
+  info.assign ("addr", addr);
+  info.assign ("family", fam);
+  info.assign ("socktype", socktype);
+  info.assign ("protocol", protocol);
+  return octave_value (info);
+}
+
+// PKG_ADD: autoload ("resolver_stats", which ("socket"));
+// PKG_DEL: try; autoload ("resolver_stats", which ("socket"), "remove"); catch; end;
+// function to report and configure the resolver cache
+DEFUN_DLD(resolver_stats, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {@var{stats} =} resolver_stats ()\n\
+@deftypefnx {Loadable Function} {@var{stats} =} resolver_stats (@var{prop}, @var{val}, @dots{})\n\
+Return statistics of the host name cache, or configure it.\n\
+\n\
+@var{stats} is a struct with the fields:\n\
+\n\
+@table @code\n\
+@item entries\n\
+the number of host names in the cache, including stale ones\n\
+\n\
+@item hits\n\
+@itemx negative_hits\n\
+the number of look ups answered from the cache with addresses, or with\n\
+a failure\n\
+\n\
+@item lookups\n\
+@itemx failures\n\
+the number of calls to @code{getaddrinfo}, and how many of them failed\n\
+\n\
+@item ttl\n\
+@itemx negative_ttl\n\
+the time in seconds for which addresses, or failures, are cached\n\
+@end table\n\
+\n\
+The properties @qcode{\"ttl\"} and @qcode{\"negative_ttl\"} set these\n\
+times for the look ups made from then on.  A time of 0 disables\n\
+caching.  The defaults are 60 and 5 seconds.\n\
+@seealso{resolver_flush, getaddrinfo}\n\
+@end deftypefn")
+{
+  const octave_idx_type nargin = args.length ();
+  if (nargin % 2 != 0)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  for (octave_idx_type i = 0; i < nargin; i += 2)
+    {
+      const std::string opt = args(i).string_value ();
+      const double val = args(i+1).double_value ();
+      if (error_state || val < 0)
+        {
+          error ("resolver_stats: properties must be given as names and non-negative numbers of seconds");
+          return octave_value ();
+        }
+      if (opt == "ttl")
+        resolver_ttl = val;
+      else if (opt == "negative_ttl")
+        resolver_negative_ttl = val;
+      else
+        {
+          error ("resolver_stats: unknown property \"%s\"", opt.c_str ());
+          return octave_value ();
+        }
+    }
+
+  octave_scalar_map stats;
+  stats.assign ("entries", octave_value (double (resolver_cache.size ())));
+  stats.assign ("hits", octave_value (resolver_hits));
+  stats.assign ("negative_hits", octave_value (resolver_negative_hits));
+  stats.assign ("lookups", octave_value (resolver_lookups));
+  stats.assign ("failures", octave_value (resolver_failures));
+  stats.assign ("ttl", octave_value (resolver_ttl));
+  stats.assign ("negative_ttl", octave_value (resolver_negative_ttl));
+  return octave_value (stats);
+}
+
+// PKG_ADD: autoload ("resolver_flush", which ("socket"));
+// PKG_DEL: try; autoload ("resolver_flush", which ("socket"), "remove"); catch; end;
+// function to empty the resolver cache
+DEFUN_DLD(resolver_flush, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {} resolver_flush ()\n\
+@deftypefnx {Loadable Function} {} resolver_flush (@var{hostname})\n\
+Forget cached host names.\n\
+\n\
+Removes @var{hostname}, or every host name, from the cache so that the\n\
+next look up queries the name service again.  The counters of\n\
+@code{resolver_stats} are reset when the whole cache is flushed.\n\
+@seealso{resolver_stats}\n\
+@end deftypefn")
+{
+  const octave_idx_type nargin = args.length ();
+  if (nargin > 1)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  if (nargin == 0)
+    {
+      resolver_cache.clear ();
+      resolver_hits = 0;
+      resolver_negative_hits = 0;
+      resolver_lookups = 0;
+      resolver_failures = 0;
+      return octave_value ();
+    }
+
+  const std::string host = args(0).string_value ();
+  if (error_state)
+    {
+      error ("resolver_flush: HOSTNAME must be a string");
+      return octave_value ();
+    }
+
+  // the cache is keyed by family and host name
+  for (std::map<std::string, resolver_entry>::iterator it
+         = resolver_cache.begin (); it != resolver_cache.end (); )
+    {
+      const std::string& key = it->first;
+      const size_t colon = key.find (':');
+      if (key.compare (colon + 1, std::string::npos, host) == 0)
+        resolver_cache.erase (it++);
+      else
+        it++;
+    }
+  return octave_value ();
+}
+
+/*
+ * helper function to get a pointer to the raw storage of a numeric,
+ * logical or char array without converting or copying it.  NBYTES is
+ * set to the size of the storage and WORDSIZE to the size of the
+ * scalar words it is made of (the real and imaginary parts of complex
+ * values are separate words).  Returns 0 if DATA has no such storage.
+ */
+static const char* get_raw_data (const octave_value& data, size_t& nbytes,
+                                 size_t& wordsize)
+{
+  nbytes = 0;
+  wordsize = 1;
+  if (data.is_sparse_type () || data.is_range ()
+      || ! (data.is_numeric_type () || data.is_bool_type ()
+            || data.is_string ()))
+    return 0;
+
+  const octave_idx_type n = data.numel ();
+  nbytes = data.byte_size ();
+  if (n > 0)
+    {
+      wordsize = nbytes / n;
+      if (data.is_complex_type ())
+        wordsize /= 2;
+    }
+
+  if (n == 0)
+    return "";
+
+  return static_cast<const char*> (data.mex_get_data ());
+}
+
+/*
+ * true if the host stores multibyte words most significant byte first,
+ * i.e. host order is network order.
+ */
+static inline bool host_is_big_endian ()
+{
+  return htons (1) == 1;
+}
+
+static inline uint16_t swap_word (uint16_t x)
+{
+  return (x >> 8) | (x << 8);
+}
+
+static inline uint32_t swap_word (uint32_t x)
+{
+  return (x >> 24) | ((x >> 8) & 0x0000ff00u)
+         | ((x << 8) & 0x00ff0000u) | (x << 24);
+}
+
+static inline uint64_t swap_word (uint64_t x)
+{
+  return (uint64_t (swap_word (uint32_t (x))) << 32)
+         | swap_word (uint32_t (x >> 32));
+}
+
+/*
+ * reverse the byte order of the N words of type T in SRC, writing the
+ * result to DST (which may be the same as SRC).  The loop body is kept
+ * free of branches so that the compiler can vectorize it.
+ */
+template <typename T>
+static void swap_words (T* dst, const T* src, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+    dst[i] = swap_word (src[i]);
+}
+
+/*
+ * reverse the byte order of every WORDSIZE byte word in the NBYTES
+ * bytes at SRC, writing the result to DST.
+ */
+static void swap_bytes (void* dst, const void* src, size_t nbytes,
+                        size_t wordsize)
+{
+  switch (wordsize)
+    {
+    case 2:
+      swap_words (static_cast<uint16_t*> (dst),
+                  static_cast<const uint16_t*> (src), nbytes / 2);
+      break;
+    case 4:
+      swap_words (static_cast<uint32_t*> (dst),
+                  static_cast<const uint32_t*> (src), nbytes / 4);
+      break;
+    case 8:
+      swap_words (static_cast<uint64_t*> (dst),
+                  static_cast<const uint64_t*> (src), nbytes / 8);
+      break;
+    default:
+      if (dst != src)
+        memcpy (dst, src, nbytes);
+      break;
+    }
+}
+
+/*
+ * helper function to parse a BYTEORDER option value.  Returns true if
+ * data in that byte order has to be byte swapped on this host.  Sets
+ * error_state for an unknown byte order.
+ */
+static bool byteorder_needs_swap (const octave_value& arg, const char* who)
+{
+  const std::string order = arg.string_value ();
+  if (error_state)
+    {
+      error ("%s: BYTEORDER must be a string", who);
+      return false;
+    }
+
+  bool big_endian;
+  if (order == "native")
+    return false;
+  else if (order == "network" || order == "ieee-be" || order == "b")
+    big_endian = true;
+  else if (order == "ieee-le" || order == "l")
+    big_endian = false;
+  else
+    {
+      error ("%s: unknown BYTEORDER \"%s\"", who, order.c_str ());
+      return false;
+    }
+
+  return big_endian != host_is_big_endian ();
+}
+
+/*
+ * helper function returning the size in bytes of one element of the
+ * octave class CLS, or 0 if arrays of that class can not be received.
+ */
+static size_t class_word_size (const std::string& cls)
+{
+  if (cls == "uint8" || cls == "int8" || cls == "char" || cls == "logical")
+    return 1;
+  else if (cls == "uint16" || cls == "int16")
+    return 2;
+  else if (cls == "uint32" || cls == "int32" || cls == "single")
+    return 4;
+  else if (cls == "uint64" || cls == "int64" || cls == "double")
+    return 8;
+  return 0;
+}
+
+/*
+ * helper function to convert a DIMS argument to a dim_vector.  Sets
+ * error_state if it is not a vector of at least two non-negative
+ * integers.
+ */
+static dim_vector get_dims (const octave_value& arg, const char* who)
+{
+  dim_vector dv;
+  const Array<octave_idx_type> d = arg.octave_idx_type_vector_value ();
+  if (error_state || d.numel () < 2)
+    {
+      error ("%s: DIMS must be a vector of at least two integers", who);
+      return dv;
+    }
+
+  dv.resize (d.numel ());
+  for (octave_idx_type i = 0; i < d.numel (); i++)
+    {
+      if (d(i) < 0)
+        {
+          error ("%s: DIMS must be non-negative", who);
+          return dim_vector ();
+        }
+      dv(i) = d(i);
+    }
+  return dv;
+}
+
+/*
+ * options shared by the functions sending and receiving arrays, given
+ * as optional FLAGS followed by property/value pairs.
+ */
+enum
+{
+  IO_OPT_BYTEORDER = 1,
+  IO_OPT_CLASS = 2,
+  IO_OPT_DIMS = 4,
+  IO_OPT_TIMEOUT = 8,
+  IO_OPT_MAX_LEN = 16,
+  IO_OPT_ZEROCOPY = 32,
+  IO_OPT_MAX_QUEUE = 64
+};
+
+struct io_options
+{
+  io_options ()
+    : flags (0), swap (false), cls ("uint8"), have_dims (false),
+      deadline (-1), max_len (64 << 20), zerocopy (false),
+      max_queue (std::numeric_limits<size_t>::max ())
+  { }
+
+  int flags;
+  bool swap;
+  std::string cls;
+  dim_vector dv;
+  bool have_dims;
+  // monotonic time at which to give up, negative for never
+  double deadline;
+  // longest message or matrix recv_msg and recv_matrix accept
+  size_t max_len;
+  bool zerocopy;
+  // bytes send_multi may queue per socket
+  size_t max_queue;
+};
+
+/*
+ * helper function to parse the optional FLAGS argument at position
+ * FIRST of ARGS and the property/value pairs following it.  Only the
+ * properties in the ALLOWED mask are accepted.  Sets error_state on
+ * invalid arguments.
+ */
+static void get_io_options (const octave_value_list& args,
+                            octave_idx_type first, int allowed,
+                            io_options& opts, const char* who)
+{
+  const octave_idx_type nargin = args.length ();
+
+  octave_idx_type nopt = first;
+  if (nargin > first && ! args(first).is_string ())
+    {
+      opts.flags = args(first).int_value ();
+      if (error_state)
+        {
+          error ("%s: FLAGS must be a scalar integer", who);
+          return;
+        }
+      nopt++;
+    }
+
+  if ((nargin - nopt) % 2 != 0)
+    {
+      print_usage ();
+      return;
+    }
+  for (octave_idx_type i = nopt; i < nargin; i += 2)
+    {
+      const std::string opt = args(i).string_value ();
+      if (error_state)
+        {
+          error ("%s: option names must be strings", who);
+          return;
+        }
+      if (opt == "byteorder" && (allowed & IO_OPT_BYTEORDER))
+        opts.swap = byteorder_needs_swap (args(i+1), who);
+      else if (opt == "class" && (allowed & IO_OPT_CLASS))
+        {
+          opts.cls = args(i+1).string_value ();
+          if (error_state || class_word_size (opts.cls) == 0)
+            error ("%s: unsupported CLASS", who);
+        }
+      else if (opt == "dims" && (allowed & IO_OPT_DIMS))
+        {
+          opts.dv = get_dims (args(i+1), who);
+          opts.have_dims = true;
+        }
+      else if (opt == "timeout" && (allowed & IO_OPT_TIMEOUT))
+        {
+          const double timeout = args(i+1).double_value ();
+          if (error_state)
+            error ("%s: TIMEOUT must be a scalar number of seconds", who);
+          else if (timeout >= 0
+                   && timeout <= std::numeric_limits<double>::max ())
+            opts.deadline = monotonic_time () + timeout;
+        }
+      else if (opt == "maxlen" && (allowed & IO_OPT_MAX_LEN))
+        {
+          const double max_len = args(i+1).double_value ();
+          if (error_state || max_len < 0)
+            error ("%s: MAXLEN must be a non-negative number of bytes", who);
+          else if (max_len < double (std::numeric_limits<size_t>::max ()))
+            opts.max_len = max_len;
+        }
+      else if (opt == "max_queue" && (allowed & IO_OPT_MAX_QUEUE))
+        {
+          const double max_queue = args(i+1).double_value ();
+          if (error_state || max_queue < 0)
+            error ("%s: MAX_QUEUE must be a non-negative number of bytes", who);
+          else if (max_queue < double (std::numeric_limits<size_t>::max ()))
+            opts.max_queue = max_queue;
+        }
+      else if (opt == "zerocopy" && (allowed & IO_OPT_ZEROCOPY))
+        {
+          opts.zerocopy = args(i+1).bool_value ();
+          if (error_state)
+            error ("%s: ZEROCOPY must be a logical value", who);
+        }
+      else
+        error ("%s: unknown option \"%s\"", who, opt.c_str ());
+
+      if (error_state)
+        return;
+    }
+}
+
+/*
+ * helper function to get the bytes to send for DATA.  If they have to
+ * be byte swapped, this is done into SWAPPED since the storage of DATA
+ * may be shared with other variables.  Ranges, which have no storage,
+ * are expanded into SWAPPED as well.  Sets error_state if DATA can not
+ * be sent.
+ */
+static const char* get_send_data (const octave_value& data, bool swap,
+                                  std::vector<uint64_t>& swapped,
+                                  size_t& nbytes, const char* who)
+{
+  if (data.is_range ())
+    {
+      const NDArray a = data.array_value ();
+      nbytes = a.byte_size ();
+      if (nbytes == 0)
+        return "";
+      swapped.resize (a.numel ());
+      memcpy (&swapped[0], a.data (), nbytes);
+      if (swap)
+        swap_bytes (&swapped[0], &swapped[0], nbytes, sizeof (double));
+      return reinterpret_cast<const char*> (&swapped[0]);
+    }
+
+  size_t wordsize;
+  const char* buf = get_raw_data (data, nbytes, wordsize);
+  if (! buf)
+    {
+      error ("%s: invalid DATA to send.  Please format it prior to sending",
+             who);
+      return 0;
+    }
+
+  if (swap && wordsize > 1)
+    {
+      swapped.resize ((nbytes + 7) / 8);
+      swap_bytes (&swapped[0], buf, nbytes, wordsize);
+      buf = reinterpret_cast<const char*> (&swapped[0]);
+    }
+  return buf;
+}
+
+/*
+ * helper function to compute the number of bytes to receive from the
+ * LEN argument and the class and dimensions in OPTS, setting OPTS.dv
+ * if no dimensions were given.  Sets error_state if they don't agree.
+ */
+static octave_idx_type get_recv_len (const octave_value& arg,
+                                     io_options& opts, const char* who)
+{
+  const octave_idx_type wordsize = class_word_size (opts.cls);
+  if (opts.have_dims && arg.is_empty ())
+    return opts.dv.numel () * wordsize;
+
+  const octave_idx_type len = arg.idx_type_value ();
+  if (error_state || len < 0)
+    {
+      error ("%s: LEN must be a non-negative integer", who);
+      return -1;
+    }
+  if (len % wordsize != 0)
+    {
+      error ("%s: LEN must be a multiple of the %s element size", who,
+             opts.cls.c_str ());
+      return -1;
+    }
+  if (! opts.have_dims)
+    opts.dv = dim_vector (1, len / wordsize);
+  else if (opts.dv.numel () * wordsize != len)
+    {
+      error ("%s: LEN does not match DIMS", who);
+      return -1;
+    }
+  return len;
+}
+
+/*
+ * helper function to copy to BUF up to LEN bytes that an earlier receive
+ * on socket S left over, see finish_recv_data.  Returns their number.
+ * They are kept for the next receive if FLAGS has MSG_PEEK.
+ */
+static size_t take_recv_rest (int s, char* buf, size_t len, int flags)
+{
+  std::map<int, socket_state>::iterator it = socket_states.find (s);
+  if (it == socket_states.end () || it->second.recv_rest.empty ())
+    return 0;
+
+  std::string& rest = it->second.recv_rest;
+  const size_t n = std::min (rest.size (), len);
+  memcpy (buf, rest.data (), n);
+  if (! (flags & MSG_PEEK))
+    rest.erase (0, n);
+  return n;
+}
+
+/*
+ * helper function to build the DATA output of the receiving functions
+ * once COUNT of the LEN bytes requested have been received into DATA
+ * from socket S.  Partially received arrays are returned as a row vector
+ * of the complete elements, and COUNT is set to their size in bytes.
+ * The bytes of an incomplete last element are put back for the next
+ * receive on a stream socket, and dropped otherwise.
+ */
+static octave_value finish_recv_data (recv_array data, ssize_t& count,
+                                      octave_idx_type len,
+                                      const io_options& opts, int s)
+{
+  if (count <= 0)
+    return recv_array (opts.cls, dim_vector (0, 0)).value ();
+
+  const size_t wordsize = class_word_size (opts.cls);
+  const octave_idx_type n = count / wordsize;
+  const size_t rest = count - n * wordsize;
+  if (rest > 0 && ! (opts.flags & MSG_PEEK)
+      && socket_type (s) == SOCK_STREAM)
+    socket_states[s].recv_rest.insert (0, data.data () + n * wordsize, rest);
+  count = n * wordsize;
+  if (count < len)
+    {
+      recv_array short_data (opts.cls, dim_vector (1, n));
+      memcpy (short_data.data (), data.data (), n * wordsize);
+      data = short_data;
+    }
+  if (opts.swap)
+    swap_bytes (data.data (), data.data (), n * wordsize, wordsize);
+
+  return data.value ();
+}
+
+#ifdef MSG_DONTWAIT
+static const int nowait_flag = MSG_DONTWAIT;
+#else
+static const int nowait_flag = 0;
+#endif
+
+/*
+ * helper function for waits that must honour Ctrl-C.  Checks for an
+ * interrupt and returns the number of milliseconds to wait next, which
+ * is at most 100, and 0 once the monotonic time DEADLINE has passed
+ * (never if DEADLINE is negative).
+ */
+static int wait_slice_ms (double deadline)
+{
+  octave_quit ();
+
+  int slice_ms = 100;
+  if (deadline >= 0)
+    {
+      const double left = deadline - monotonic_time ();
+      if (left <= 0)
+        slice_ms = 0;
+      else if (left * 1e3 < slice_ms)
+        slice_ms = int (left * 1e3) + 1;
+    }
+  return slice_ms;
+}
+
+/*
+ * helper function to wait until socket S is readable, or writable if
+ * WRITE is true, or until the monotonic time DEADLINE has passed (never
+ * if DEADLINE is negative).  Returns 1 when ready, 0 on timeout and -1
+ * on error with errno set.
+ */
+static int wait_socket (int s, bool write, double deadline)
+{
+  for (;;)
+    {
+      const int slice_ms = wait_slice_ms (deadline);
+
+#ifndef __WIN32__
+      struct pollfd pfd;
+      pfd.fd = s;
+      pfd.events = write ? POLLOUT : POLLIN;
+      pfd.revents = 0;
+      const int rc = ::poll (&pfd, 1, slice_ms);
+#else
+      fd_set set;
+      FD_ZERO (&set);
+      FD_SET (s, &set);
+      struct timeval tv;
+      tv.tv_sec = slice_ms / 1000;
+      tv.tv_usec = (slice_ms % 1000) * 1000;
+      const int rc = ::select (s + 1, write ? 0 : &set, write ? &set : 0, 0,
+                               &tv);
+#endif
+      if (rc > 0)
+        return 1;
+      else if (rc < 0 && errno != EINTR)
+        return -1;
+      else if (slice_ms == 0)
+        return 0;
+    }
+}
+
+/*
+ * helper function to transfer all LEN bytes of BUF over socket S,
+ * sending if WRITE is true and receiving otherwise.  Each chunk is
+ * first tried without blocking and the socket is only waited on when
+ * it would block, so that a stream of data costs one syscall per chunk.
+ * Stops early on timeout or, when receiving, on orderly shutdown by
+ * the peer.  Returns the number of bytes transferred, or -1 on error
+ * with errno set.  If DONE_OUT is given, it is set to the number of
+ * bytes transferred also on error.
+ */
+static ssize_t transfer_all (int s, char* buf, size_t len, bool write,
+                             int flags, double deadline,
+                             size_t* done_out = 0)
+{
+  size_t done = 0;
+  bool need_wait = (nowait_flag == 0);
+  while (done < len)
+    {
+      if (done_out)
+        *done_out = done;
+      if (need_wait)
+        {
+          const int rc = wait_socket (s, write, deadline);
+          if (rc <= 0)
+            return rc == 0 ? ssize_t (done) : -1;
+        }
+      else
+        octave_quit ();
+
+      const double t0 = io_clock ();
+      const ssize_t n = write
+        ? ::send (s, buf + done, len - done, flags | nowait_flag)
+        : ::recv (s, buf + done, len - done, flags | nowait_flag);
+      count_io (s, write ? IO_SEND : IO_RECV, n, len - done, t0);
+      if (n > 0)
+        {
+          done += n;
+          need_wait = (nowait_flag == 0);
+        }
+      else if (n == 0 && ! write)
+        break;
+      else if (n < 0 && errno == EINTR)
+        need_wait = (nowait_flag == 0);
+      else if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+        return -1;
+      else
+        need_wait = true;
+    }
+  if (done_out)
+    *done_out = done;
+  return done;
+}
+
+/*
+ * helper function to send all the N buffers of IOV over socket S as one
+ * stream, using scatter-gather I/O so that headers and array storage
+ * need not be copied into one buffer.  IOV is modified.  Returns the
+ * number of bytes sent, which is short only on timeout, or -1 on error
+ * with errno set.
+ */
+static ssize_t send_all_iov (int s, struct iovec* iov, int n, int flags,
+                             double deadline)
+{
+#ifndef __WIN32__
+  size_t done = 0;
+  bool need_wait = (nowait_flag == 0);
+  while (n > 0)
+    {
+      if (iov->iov_len == 0)
+        {
+          iov++;
+          n--;
+          continue;
+        }
+
+      if (need_wait)
+        {
+          const int rc = wait_socket (s, true, deadline);
+          if (rc <= 0)
+            return rc == 0 ? ssize_t (done) : -1;
+        }
+      else
+        octave_quit ();
+
+      struct msghdr msg;
+      memset (&msg, 0, sizeof (msg));
+      msg.msg_iov = iov;
+      msg.msg_iovlen = n;
+      size_t want = 0;
+      for (int i = 0; i < n; i++)
+        want += iov[i].iov_len;
+      const double t0 = io_clock ();
+      ssize_t k = ::sendmsg (s, &msg, flags | nowait_flag);
+      count_io (s, IO_SEND, k, want, t0);
+      if (k > 0)
+        {
+          done += k;
+          while (k > 0 && size_t (k) >= iov->iov_len)
+            {
+              k -= iov->iov_len;
+              iov++;
+              n--;
+            }
+          if (k > 0)
+            {
+              iov->iov_base = static_cast<char*> (iov->iov_base) + k;
+              iov->iov_len -= k;
+            }
+          need_wait = (nowait_flag == 0);
+        }
+      else if (k < 0 && errno == EINTR)
+        need_wait = (nowait_flag == 0);
+      else if (k < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+        return -1;
+      else
+        need_wait = true;
+    }
+  return done;
+#else
+  size_t done = 0;
+  for (int i = 0; i < n; i++)
+    {
+      const ssize_t k = transfer_all (s, static_cast<char*> (iov[i].iov_base),
+                                      iov[i].iov_len, true, flags, deadline);
+      if (k < 0)
+        return -1;
+      done += k;
+      if (size_t (k) < iov[i].iov_len)
+        break;
+    }
+  return done;
+#endif
+}
+
+/*
+ * helper function to read at most LEN bytes from socket S into BUF,
+ * waiting for data until DEADLINE unless FLAGS contains MSG_DONTWAIT.
+ * Returns the number of bytes read, 0 if the peer shut down, -1 on
+ * error with errno set and -2 if no data arrived in time.
+ */
+static ssize_t recv_some (int s, char* buf, size_t len, int flags,
+                          double deadline)
+{
+  const bool dontwait = (flags & nowait_flag) != 0;
+  for (;;)
+    {
+      const double t0 = io_clock ();
+      const ssize_t n = ::recv (s, buf, len, flags | nowait_flag);
+      count_io (s, IO_RECV, n, len, t0);
+      if (n >= 0)
+        return n;
+      else if (errno == EINTR)
+        continue;
+      else if (errno != EAGAIN && errno != EWOULDBLOCK)
+        return -1;
+      else if (dontwait)
+        return -2;
+
+      const int rc = wait_socket (s, false, deadline);
+      if (rc <= 0)
+        return rc == 0 ? -2 : -1;
+    }
+}
+
+/*
+ * helper function to switch socket S to non-blocking mode, or back to
+ * blocking mode if ON is false.  Returns whether it was non-blocking
+ * before, or -1 on error with errno set.
+ */
+static int set_nonblocking (int s, bool on)
+{
+#ifndef __WIN32__
+  const int fl = fcntl (s, F_GETFL, 0);
+  if (fl == -1)
+    return -1;
+  if (fcntl (s, F_SETFL, on ? (fl | O_NONBLOCK) : (fl & ~O_NONBLOCK)) == -1)
+    return -1;
+  return (fl & O_NONBLOCK) != 0;
+#else
+  u_long mode = on;
+  if (ioctlsocket (s, FIONBIO, &mode) != 0)
+    return -1;
+  // the mode can not be queried on windows
+  return 0;
+#endif
+}
+
+/*
+ * helper function to start connecting socket S to SA without blocking.
+ * Returns 0 if connected, 1 if the connection is in progress and -1 on
+ * error with errno set.  S must be non-blocking.
+ */
+static int connect_start (int s, const struct sockaddr_storage& sa)
+{
+  int rc;
+  do
+    rc = ::connect (s, (const struct sockaddr*)&sa, sockaddr_len (sa));
+  while (rc == -1 && errno == EINTR);
+  if (rc == 0)
+    return 0;
+#ifndef __WIN32__
+  if (errno == EINPROGRESS)
+    return 1;
+#else
+  if (WSAGetLastError () == WSAEWOULDBLOCK)
+    return 1;
+#endif
+  return -1;
+}
+
+/*
+ * helper function to get the result of a connection started by
+ * connect_start on socket S once it is writable.  Returns 0 if it
+ * succeeded and -1 otherwise with errno set.
+ */
+static int connect_result (int s)
+{
+  int err = 0;
+  socklen_t len = sizeof (err);
+#ifndef __WIN32__
+  if (getsockopt (s, SOL_SOCKET, SO_ERROR, &err, &len) == -1)
+#else
+  if (getsockopt (s, SOL_SOCKET, SO_ERROR, (char*)&err, (int*)&len) == -1)
+#endif
+    return -1;
+  errno = err;
+  return err == 0 ? 0 : -1;
+}
+
+/*
+ * helper function to connect socket S to SA, giving up at the monotonic
+ * time DEADLINE (never if negative).  Waiting is done in short slices
+ * so that Ctrl-C is honoured.  The blocking mode of S is kept.  Returns
+ * 0 on success and -1 on error with errno set, ETIMEDOUT on timeout.
+ */
+static int connect_timed (int s, const struct sockaddr_storage& sa,
+                          double deadline)
+{
+  const int was_nonblocking = set_nonblocking (s, true);
+  if (was_nonblocking == -1)
+    return -1;
+
+  int rc = connect_start (s, sa);
+  if (rc == 1 && ! was_nonblocking)
+    {
+      rc = wait_socket (s, true, deadline);
+      if (rc == 1)
+        rc = connect_result (s);
+      else if (rc == 0)
+        {
+          errno = ETIMEDOUT;
+          rc = -1;
+        }
+    }
+  else if (rc == 1)
+    {
+      // a non-blocking socket keeps connecting in the background
+      errno = EINPROGRESS;
+      rc = -1;
+    }
+
+  const int err = errno;
+  if (! was_nonblocking)
+    set_nonblocking (s, false);
+  errno = err;
+  return rc;
+}
+
+// PKG_ADD: autoload ("connect", which ("socket"));
+// PKG_DEL: try; autoload ("connect", which ("socket"), "remove"); catch; end;
+// function to create an outgoing connection
+DEFUN_DLD(connect, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {} connect (@var{s}, @var{serverinfo})\n\
+@deftypefnx {Loadable Function} {} connect (@var{s}, @var{serverinfo}, \"timeout\", @var{timeout})\n\
+Connect socket.\n\
+\n\
+Connects the socket @var{s} following the information\n\
+in the struct @var{serverinfo} which must contain the\n\
+following fields:\n\
+\n\
+@table @code\n\
+@item addr\n\
+a string with the host name to connect to\n\
+\n\
+@item port\n\
+the port number to connect to (an integer)\n\
+@end table\n\
+\n\
+For AF_UNIX sockets, @var{serverinfo} is the path of the socket to\n\
+connect to, or a struct with the path in field @code{addr}.  A path\n\
+starting with @qcode{\"@@\"} names a socket in the abstract namespace\n\
+of Linux, which has no file.\n\
+\n\
+The @qcode{\"timeout\"} property sets the maximum time in seconds to wait\n\
+for the connection to be established, as for @code{sendall}.  Without\n\
+it, @code{connect} waits as long as the system does, but can be\n\
+interrupted with Ctrl-C.  After a timeout the socket can not be\n\
+connected again and should be closed.\n\
+\n\
+On successful connect, the returned status is zero.\n\
+\n\
+See the @command{connect} man pages for further details.\n\
+@seealso{connect_many}\n\
+@end deftypefn")
+{
+  const octave_idx_type nargin = args.length ();
+  if (nargin != 2 && nargin != 4)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  // Determine the socket on which to operate
+  const int s = get_socket (args(0));
+  if (error_state)
+    {
+      error ("connect: S must be a valid socket");
+      return octave_value ();
+    }
+
+  io_options opts;
+  get_io_options (args, 2, IO_OPT_TIMEOUT, opts, "connect");
+  if (error_state)
+    return octave_value ();
+
+  // Extract information about the server to connect to.
+  struct sockaddr_storage serverInfo;
+  get_sockaddr (args(1), socket_family (s), serverInfo, "connect",
+                "SERVERINFO");
+  if (error_state)
+    return octave_value ();
+
+  const int retval = connect_timed (s, serverInfo, opts.deadline);
+  if (retval == -1)
+      error ("connect failed with error %i (%s)", errno, strerror(errno));
+  else
+    {
+      socket_state& st = socket_states[s];
+      st.have_peer = true;
+      st.peer = serverInfo;
+    }
+
+  return octave_value (retval);
+}
+
+// PKG_ADD: autoload ("connect_many", which ("socket"));
+// PKG_DEL: try; autoload ("connect_many", which ("socket"), "remove"); catch; end;
+// function to create many outgoing connections at once
+#ifndef __WIN32__
+DEFUN_DLD(connect_many, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {[@var{status}, @var{msg}] =} connect_many (@var{sockets}, @var{serverinfo})\n\
+@deftypefnx {Loadable Function} {[@var{status}, @var{msg}] =} connect_many (@var{sockets}, @var{serverinfo}, \"timeout\", @var{timeout})\n\
+Connect several sockets at once.\n\
+\n\
+Connects each of @var{sockets}, an array or a cell array of sockets, to\n\
+the corresponding element of @var{serverinfo}, a struct array or a cell\n\
+array of structs with the fields @code{addr} and @code{port} as for\n\
+@code{connect}.  A single struct connects all sockets to the same\n\
+server.  All connections are started at once and then waited for\n\
+together, so that the whole takes about as long as the slowest one.\n\
+\n\
+The @qcode{\"timeout\"} property sets the maximum time in seconds to\n\
+wait, as for @code{connect}.  Without it, wait until every connection\n\
+has either been established or failed.\n\
+\n\
+@var{status} has the size of @var{sockets} and is 0 for each socket\n\
+that connected and -1 for each one that failed or timed out, in which\n\
+case the cell array @var{msg} holds the error message.  Unlike\n\
+@code{connect}, failures are not errors.\n\
+@seealso{connect}\n\
+@end deftypefn")
+{
+  const octave_idx_type nargin = args.length ();
+  if (nargin != 2 && nargin != 4)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  io_options opts;
+  get_io_options (args, 2, IO_OPT_TIMEOUT, opts, "connect_many");
+  if (error_state)
+    return octave_value ();
+  const double deadline = opts.deadline;
+
+  const Array<int> fds = get_socket_array (args(0));
+  if (error_state)
+    {
+      error ("connect_many: SOCKETS must be an array or a cell array of sockets");
+      return octave_value ();
+    }
+  const octave_idx_type n = fds.numel ();
+
+  Cell infos;
+  if (args(1).is_cell ())
+    infos = args(1).cell_value ();
+  else if (args(1).is_map ())
+    {
+      const octave_map m = args(1).map_value ();
+      infos = Cell (m.dims ());
+      for (octave_idx_type i = 0; i < m.numel (); i++)
+        infos(i) = octave_value (m.checkelem (i));
+    }
+  else
+    {
+      error ("connect_many: SERVERINFO must be a struct array or a cell array of structs");
+      return octave_value ();
+    }
+  if (infos.numel () != 1 && infos.numel () != n)
+    {
+      error ("connect_many: SERVERINFO must have one element or one per socket");
+      return octave_value ();
+    }
+
+  // Look up every address before touching any socket
+  std::vector<struct sockaddr_storage> addrs (n);
+  for (octave_idx_type i = 0; i < n; i++)
+    {
+      get_sockaddr (infos(infos.numel () == 1 ? 0 : i), socket_family (fds(i)),
+                    addrs[i], "connect_many", "SERVERINFO");
+      if (error_state)
+        return octave_value ();
+    }
+
+  NDArray status (args(0).dims (), 0);
+  Cell msg (args(0).dims (), octave_value (""));
+  std::vector<int> was_nonblocking (n, 1);
+  std::vector<struct pollfd> pending;
+  std::vector<octave_idx_type> pending_idx;
+
+  // Start all handshakes
+  for (octave_idx_type i = 0; i < n; i++)
+    {
+      was_nonblocking[i] = set_nonblocking (fds(i), true);
+      const int rc = was_nonblocking[i] == -1 ? -1 : connect_start (fds(i), addrs[i]);
+      if (rc == 1)
+        {
+          struct pollfd pfd;
+          pfd.fd = fds(i);
+          pfd.events = POLLOUT;
+          pfd.revents = 0;
+          pending.push_back (pfd);
+          pending_idx.push_back (i);
+        }
+      else if (rc == -1)
+        {
+          status(i) = -1;
+          msg(i) = octave_value (std::string (strerror (errno)));
+        }
+    }
+
+  // Wait for them in short slices so that Ctrl-C is honoured
+  while (! pending.empty ())
+    {
+      const int slice_ms = wait_slice_ms (deadline);
+      const int rc = ::poll (&pending[0], pending.size (), slice_ms);
+      if (rc == -1 && errno != EINTR)
+        {
+          error ("connect_many: poll failed with error %i (%s)", errno,
+                 strerror(errno));
+          break;
+        }
+      else if (rc <= 0 && slice_ms == 0)
+        {
+          for (size_t j = 0; j < pending_idx.size (); j++)
+            {
+              status(pending_idx[j]) = -1;
+              msg(pending_idx[j]) = octave_value (std::string (strerror (ETIMEDOUT)));
+            }
+          break;
+        }
+
+      size_t k = 0;
+      for (size_t j = 0; j < pending.size (); j++)
+        {
+          const octave_idx_type i = pending_idx[j];
+          if (pending[j].revents == 0)
+            {
+              pending[k] = pending[j];
+              pending_idx[k++] = i;
+            }
+          else if (connect_result (fds(i)) == -1)
+            {
+              status(i) = -1;
+              msg(i) = octave_value (std::string (strerror (errno)));
+            }
+        }
+      pending.resize (k);
+      pending_idx.resize (k);
+    }
+
+  for (octave_idx_type i = 0; i < n; i++)
+    {
+      if (was_nonblocking[i] == 0)
+        set_nonblocking (fds(i), false);
+      if (status(i) == 0)
+        {
+          socket_state& st = socket_states[fds(i)];
+          st.have_peer = true;
+          st.peer = addrs[i];
+        }
+    }
+  if (error_state)
+    return octave_value ();
+
+  octave_value_list return_list;
+  return_list(0) = status;
+  return_list(1) = msg;
+  return return_list;
+}
+#else
+DEFUNX_DLD ("connect_many", Fconnect_many, Gconnect_many, args, nargout, "(not supported)")
+{ error( "connect_many: not supported on this platform" );
+  return octave_value(); };
+#endif
+
+/*
+ * The connection pools.  A pool keeps connections to one server open
+ * between requests, handed to octave as a positive integer handle.
+ * Connections are kept as their socket objects, idle ones with the
+ * time they were returned, most recently returned last.
+ */
+#ifndef __WIN32__
+struct pooled_conn
+{
+  octave_value sock;
+  double last_used;
+};
+
+struct conn_pool
+{
+  octave_value server;
+  int family;
+  int max_conns;
+  double idle_timeout;
+  double connect_timeout;
+  bool nodelay;
+  bool keepalive;
+  int keepidle;
+  int keepintvl;
+  int keepcnt;
+
+  std::vector<pooled_conn> idle;
+  std::map<int, octave_value> in_use;
+
+  double connects;
+  double reuses;
+  double idle_evictions;
+  double dead_evictions;
+};
+
+static std::map<int, conn_pool> conn_pools;
+static int next_conn_pool = 1;
+
+/*
+ * helper function to check that the idle pooled connection S is still
+ * usable: the peer has not closed it, no error is pending and no stray
+ * data is waiting to be read.  A peek does not consume anything.
+ */
+static bool conn_alive (int s)
+{
+  char c;
+  ssize_t n;
+  do
+    n = ::recv (s, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+  while (n == -1 && errno == EINTR);
+  return n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+/*
+ * helper function to close the pooled connection SOCK.
+ */
+static void conn_close (const octave_value& sock)
+{
+  const int s = get_socket (sock);
+  if (s >= 0)
+    close_octavesocket (s);
+}
+
+/*
+ * helper function to close the idle connections of pool P that were
+ * not used for its idle timeout, as of the monotonic time NOW.
+ */
+static void conn_pool_expire (conn_pool& p, double now)
+{
+  if (p.idle_timeout < 0)
+    return;
+
+  // The oldest connections are at the front
+  std::vector<pooled_conn>::iterator it = p.idle.begin ();
+  while (it != p.idle.end () && now - it->last_used > p.idle_timeout)
+    {
+      conn_close (it->sock);
+      p.idle_evictions++;
+      it++;
+    }
+  p.idle.erase (p.idle.begin (), it);
+}
+
+/*
+ * helper function to open a new connection for pool P.  Returns the
+ * socket object, or an undefined value with the error set.
+ */
+static octave_value conn_pool_connect (conn_pool& p)
+{
+  struct sockaddr_storage sa;
+  get_sockaddr (p.server, p.family, sa, "connpool_get", "the server");
+  if (error_state || ! load_socket_type ("connpool_get"))
+    return octave_value ();
+
+  const int s = ::socket (p.family, SOCK_STREAM, 0);
+  if (s == -1)
+    {
+      error ("connpool_get: socket failed with error %i (%s)", errno,
+             strerror(errno));
+      return octave_value ();
+    }
+  fcntl (s, F_SETFD, FD_CLOEXEC);
+  const octave_value sock (new octave_socket (s, p.family, SOCK_STREAM, 0));
+
+  const int one = 1;
+  if (p.nodelay)
+    setsockopt (s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof (one));
+  if (p.keepalive)
+    {
+      setsockopt (s, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof (one));
+#if defined (TCP_KEEPIDLE) && defined (TCP_KEEPINTVL) && defined (TCP_KEEPCNT)
+      if (p.keepidle > 0)
+        setsockopt (s, IPPROTO_TCP, TCP_KEEPIDLE, &p.keepidle, sizeof (int));
+      if (p.keepintvl > 0)
+        setsockopt (s, IPPROTO_TCP, TCP_KEEPINTVL, &p.keepintvl, sizeof (int));
+      if (p.keepcnt > 0)
+        setsockopt (s, IPPROTO_TCP, TCP_KEEPCNT, &p.keepcnt, sizeof (int));
+#endif
+    }
+
+  const double deadline = p.connect_timeout < 0
+    ? -1 : monotonic_time () + p.connect_timeout;
+  if (connect_timed (s, sa, deadline) == -1)
+    {
+      const int err = errno;
+      close_octavesocket (s);
+      error ("connpool_get: connect failed with error %i (%s)", err,
+             strerror(err));
+      return octave_value ();
+    }
+
+  p.connects++;
+  return sock;
+}
+
+/*
+ * helper function to get the pool with the handle in ARG, setting
+ * error_state if there is none.
+ */
+static conn_pool* get_conn_pool (const octave_value& arg, const char* who)
+{
+  const int id = arg.int_value ();
+  std::map<int, conn_pool>::iterator it = conn_pools.find (id);
+  if (error_state || it == conn_pools.end ())
+    {
+      error ("%s: POOL must be a pool created by connpool_create", who);
+      return 0;
+    }
+  return &it->second;
+}
+
+// PKG_ADD: autoload ("connpool_create", which ("socket"));
+// PKG_DEL: try; autoload ("connpool_create", which ("socket"), "remove"); catch; end;
+// function to create a connection pool
+DEFUN_DLD(connpool_create, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {@var{pool} =} connpool_create (@var{addr}, @var{port}, @var{max})\n\
+@deftypefnx {Loadable Function} {@var{pool} =} connpool_create (@dots{}, @var{property}, @var{value}, @dots{})\n\
+Create a pool of connections to a server.\n\
+\n\
+Creates a pool that keeps up to @var{max} TCP connections to port\n\
+@var{port} of the host @var{addr} open between requests, so that each\n\
+request does not pay for a connection handshake and leave a socket in\n\
+TIME_WAIT.  Connections are taken with @code{connpool_get} and returned\n\
+with @code{connpool_put}.  No connection is opened before the first\n\
+@code{connpool_get}.\n\
+\n\
+The properties are:\n\
+\n\
+@table @asis\n\
+@item @qcode{\"family\"}\n\
+@code{AF_INET} (the default) or @code{AF_INET6}.\n\
+\n\
+@item @qcode{\"idle_timeout\"}\n\
+Seconds after which an unused connection is closed, 60 by default.\n\
+Negative values keep idle connections forever.\n\
+\n\
+@item @qcode{\"connect_timeout\"}\n\
+Seconds to wait for a new connection, forever by default.\n\
+\n\
+@item @qcode{\"nodelay\"}\n\
+If true (the default), TCP_NODELAY is set on the connections.\n\
+\n\
+@item @qcode{\"keepalive\"}\n\
+If true, TCP keep-alive probes detect peers that vanished without\n\
+closing the connection.\n\
+\n\
+@item @qcode{\"keepidle\"}\n\
+@itemx @qcode{\"keepintvl\"}\n\
+@itemx @qcode{\"keepcnt\"}\n\
+The idle time before the first probe and the time between probes in\n\
+seconds, and the number of unanswered probes after which the connection\n\
+is dropped.  Setting any of them turns keep-alive on.\n\
+@end table\n\
+@seealso{connpool_get, connpool_put, connpool_stats, connpool_close}\n\
+@end deftypefn")
+{
+  const octave_idx_type nargin = args.length ();
+  if (nargin < 3 || nargin % 2 != 1)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  conn_pool p;
+  const int port = args(1).int_value ();
+  if (! args(0).is_string () || error_state || port <= 0)
+    {
+      error ("connpool_create: ADDR must be a string and PORT a positive integer");
+      return octave_value ();
+    }
+  octave_scalar_map server;
+  server.assign ("addr", args(0));
+  server.assign ("port", port);
+  p.server = server;
+
+  p.max_conns = args(2).int_value ();
+  if (error_state || p.max_conns < 1)
+    {
+      error ("connpool_create: MAX must be a positive integer");
+      return octave_value ();
+    }
+
+  p.family = AF_INET;
+  p.idle_timeout = 60;
+  p.connect_timeout = -1;
+  p.nodelay = true;
+  p.keepalive = false;
+  p.keepidle = p.keepintvl = p.keepcnt = 0;
+  p.connects = p.reuses = p.idle_evictions = p.dead_evictions = 0;
+  for (octave_idx_type i = 3; i < nargin; i += 2)
+    {
+      const std::string name = args(i).string_value ();
+      if (error_state)
+        {
+          error ("connpool_create: PROPERTY must be a string");
+          return octave_value ();
+        }
+      const octave_value& val = args(i+1);
+      if (name == "family")
+        {
+          p.family = val.int_value ();
+          if (! error_state && p.family != AF_INET && p.family != AF_INET6)
+            {
+              error ("connpool_create: family must be AF_INET or AF_INET6");
+              return octave_value ();
+            }
+        }
+      else if (name == "idle_timeout")
+        p.idle_timeout = val.double_value ();
+      else if (name == "connect_timeout")
+        p.connect_timeout = val.double_value ();
+      else if (name == "nodelay")
+        p.nodelay = val.bool_value ();
+      else if (name == "keepalive")
+        p.keepalive = val.bool_value ();
+      else if (name == "keepidle" || name == "keepintvl" || name == "keepcnt")
+        {
+          const int v = val.int_value ();
+          if (! error_state && v < 1)
+            {
+              error ("connpool_create: %s must be a positive integer",
+                     name.c_str ());
+              return octave_value ();
+            }
+          if (name == "keepidle")
+            p.keepidle = v;
+          else if (name == "keepintvl")
+            p.keepintvl = v;
+          else
+            p.keepcnt = v;
+          p.keepalive = true;
+        }
+      else
+        {
+          error ("connpool_create: unknown property \"%s\"", name.c_str ());
+          return octave_value ();
+        }
+      if (error_state)
+        {
+          error ("connpool_create: invalid value for property \"%s\"",
+                 name.c_str ());
+          return octave_value ();
+        }
+    }
+
+  const int id = next_conn_pool++;
+  conn_pools[id] = p;
+  return octave_value (id);
+}
+
+// PKG_ADD: autoload ("connpool_get", which ("socket"));
+// PKG_DEL: try; autoload ("connpool_get", which ("socket"), "remove"); catch; end;
+// function to take a connection from a pool
+DEFUN_DLD(connpool_get, args, , "\
+-*- texinfo -*-\n\
+@deftypefn {Loadable Function} {@var{s} =} connpool_get (@var{pool})\n\
+Take a connection from a pool.\n\
+\n\
+Returns an idle connection of the pool @var{pool}, the most recently\n\
+returned one first, or opens a new one if none is left.  Idle\n\
+connections that timed out are closed, and each candidate is checked\n\
+with a non-blocking @code{MSG_PEEK}: connections that the server closed,\n\
+that have an error pending or that have unread data left over from an\n\
+earlier request are closed and not returned.\n\
+\n\
+It is an error if all connections of the pool are taken.  @var{s} must\n\
+be given back with @code{connpool_put}, also after a failed request.\n\
+@seealso{connpool_create, connpool_put}\n\
+@end deftypefn")
+{
+  if (args.length () != 1)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  conn_pool* p = get_conn_pool (args(0), "connpool_get");
+  if (error_state)
+    return octave_value ();
+
+  conn_pool_expire (*p, monotonic_time ());
+  while (! p->idle.empty ())
+    {
+      const octave_value sock = p->idle.back ().sock;
+      p->idle.pop_back ();
+      const int s = get_socket (sock);
+      if (s >= 0 && conn_alive (s))
+        {
+          p->reuses++;
+          p->in_use[s] = sock;
+          return sock;
+        }
+      conn_close (sock);
+      p->dead_evictions++;
+    }
+
+  if (int (p->in_use.size ()) >= p->max_conns)
+    {
+      error ("connpool_get: all %i connections of the pool are in use",
+             p->max_conns);
+      return octave_value ();
+    }
+
+  const octave_value sock = conn_pool_connect (*p);
+  if (error_state)
+    return octave_value ();
+  p->in_use[get_socket (sock)] = sock;
+  return sock;
+}
+
+// PKG_ADD: autoload ("connpool_put", which ("socket"));
+// PKG_DEL: try; autoload ("connpool_put", which ("socket"), "remove"); catch; end;
+// function to return a connection to a pool
+DEFUN_DLD(connpool_put, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {} connpool_put (@var{pool}, @var{s})\n\
+@deftypefnx {Loadable Function} {} connpool_put (@var{pool}, @var{s}, @var{close})\n\
+Return a connection to a pool.\n\
+\n\
+Gives the connection @var{s}, taken with @code{connpool_get}, back to\n\
+the pool @var{pool} for reuse.  If @var{close} is true, or the\n\
+connection was closed with @code{disconnect} or is no longer usable, it\n\
+is closed instead, which should be done when a request failed halfway\n\
+and the connection is in an unknown state.\n\
+@seealso{connpool_create, connpool_get}\n\
+@end deftypefn")
+{
+  const octave_idx_type nargin = args.length ();
+  if (nargin != 2 && nargin != 3)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  conn_pool* p = get_conn_pool (args(0), "connpool_put");
+  if (error_state)
+    return octave_value ();
+
+  // A socket closed by disconnect has lost its descriptor
+  std::map<int, octave_value>::iterator it = p->in_use.begin ();
+  const int s = get_socket (args(1));
+  if (error_state)
+    {
+      error ("connpool_put: S must be a socket");
+      return octave_value ();
+    }
+  else if (s >= 0)
+    it = p->in_use.find (s);
+  else
+    while (it != p->in_use.end () && get_socket (it->second) >= 0)
+      it++;
+  if (it == p->in_use.end ())
+    {
+      error ("connpool_put: S was not taken from POOL");
+      return octave_value ();
+    }
+
+  bool discard = false;
+  if (nargin > 2)
+    {
+      discard = args(2).bool_value ();
+      if (error_state)
+        {
+          error ("connpool_put: CLOSE must be a logical value");
+          return octave_value ();
+        }
+    }
+
+  const octave_value sock = it->second;
+  p->in_use.erase (it);
+  if (discard || s < 0 || ! conn_alive (s))
+    {
+      conn_close (sock);
+      if (! discard && s >= 0)
+        p->dead_evictions++;
+    }
+  else
+    {
+      pooled_conn c;
+      c.sock = sock;
+      c.last_used = monotonic_time ();
+      p->idle.push_back (c);
+      conn_pool_expire (*p, c.last_used);
+    }
+
+  return octave_value ();
+}
+
+// PKG_ADD: autoload ("connpool_stats", which ("socket"));
+// PKG_DEL: try; autoload ("connpool_stats", which ("socket"), "remove"); catch; end;
+// function to report the state of a connection pool
+DEFUN_DLD(connpool_stats, args, , "\
+-*- texinfo -*-\n\
+@deftypefn {Loadable Function} {@var{stats} =} connpool_stats (@var{pool})\n\
+Return statistics of a connection pool.\n\
+\n\
+@var{stats} is a struct with the fields:\n\
+\n\
+@table @code\n\
+@item idle\n\
+@itemx in_use\n\
+the number of connections waiting in the pool and taken from it\n\
+\n\
+@item connects\n\
+@itemx reuses\n\
+the number of connections opened, and of times an idle one was reused\n\
+\n\
+@item idle_evictions\n\
+@itemx dead_evictions\n\
+the number of connections closed because they were idle too long, and\n\
+because the check found them closed by the peer or unusable\n\
+@end table\n\
+@seealso{connpool_create, connpool_get, connpool_put}\n\
+@end deftypefn")
+{
+  if (args.length () != 1)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  conn_pool* p = get_conn_pool (args(0), "connpool_stats");
+  if (error_state)
+    return octave_value ();
+
+  octave_scalar_map stats;
+  stats.assign ("idle", double (p->idle.size ()));
+  stats.assign ("in_use", double (p->in_use.size ()));
+  stats.assign ("connects", p->connects);
+  stats.assign ("reuses", p->reuses);
+  stats.assign ("idle_evictions", p->idle_evictions);
+  stats.assign ("dead_evictions", p->dead_evictions);
+  return octave_value (stats);
+}
+
+// PKG_ADD: autoload ("connpool_close", which ("socket"));
+// PKG_DEL: try; autoload ("connpool_close", which ("socket"), "remove"); catch; end;
+// function to close a connection pool
+DEFUN_DLD(connpool_close, args, , "\
+-*- texinfo -*-\n\
+@deftypefn {Loadable Function} {} connpool_close (@var{pool})\n\
+Close a connection pool.\n\
+\n\
+Closes the idle connections of the pool @var{pool} and forgets it.\n\
+Connections still taken from it stay open until they are cleared or\n\
+closed with @code{disconnect}.\n\
+@seealso{connpool_create}\n\
+@end deftypefn")
+{
+  if (args.length () != 1)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  conn_pool* p = get_conn_pool (args(0), "connpool_close");
+  if (error_state)
+    return octave_value ();
+
+  for (size_t i = 0; i < p->idle.size (); i++)
+    conn_close (p->idle[i].sock);
+  conn_pools.erase (args(0).int_value ());
+  return octave_value ();
+}
+#else
+DEFUNX_DLD ("connpool_create", Fconnpool_create, Gconnpool_create, args, nargout, "(not supported)")
+{ error( "connpool_create: not supported on this platform" );
+  return octave_value(); };
+DEFUNX_DLD ("connpool_get", Fconnpool_get, Gconnpool_get, args, nargout, "(not supported)")
+{ error( "connpool_get: not supported on this platform" );
+  return octave_value(); };
+DEFUNX_DLD ("connpool_put", Fconnpool_put, Gconnpool_put, args, nargout, "(not supported)")
+{ error( "connpool_put: not supported on this platform" );
+  return octave_value(); };
+DEFUNX_DLD ("connpool_stats", Fconnpool_stats, Gconnpool_stats, args, nargout, "(not supported)")
+{ error( "connpool_stats: not supported on this platform" );
+  return octave_value(); };
+DEFUNX_DLD ("connpool_close", Fconnpool_close, Gconnpool_close, args, nargout, "(not supported)")
+{ error( "connpool_close: not supported on this platform" );
+  return octave_value(); };
+#endif
+
+#if defined (SO_ZEROCOPY) && defined (MSG_ZEROCOPY)
+/*
+ * helper function to read the zero-copy completions queued on the error
+ * queue of socket S without blocking, and release the arrays that the
+ * kernel is done with.  Returns the number of sends completed.
+ */
+static octave_idx_type reap_zerocopy (int s)
+{
+  std::map<int, socket_state>::iterator st_it = socket_states.find (s);
+  if (st_it == socket_states.end ())
+    return 0;
+
+  socket_state& st = st_it->second;
+  octave_idx_type completed = 0;
+  while (! st.zc_pending.empty ())
+    {
+      char control[128];
+      struct msghdr msg;
+      memset (&msg, 0, sizeof (msg));
+      msg.msg_control = control;
+      msg.msg_controllen = sizeof (control);
+      if (recvmsg (s, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) == -1)
+        {
+          if (errno == EINTR)
+            continue;
+          break;
+        }
+
+      for (struct cmsghdr* cm = CMSG_FIRSTHDR (&msg); cm;
+           cm = CMSG_NXTHDR (&msg, cm))
+        {
+          const struct sock_extended_err* ee
+            = reinterpret_cast<const struct sock_extended_err*> (CMSG_DATA (cm));
+          if (ee->ee_errno != 0 || ee->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+            continue;
+
+          // The sends from ee_info to ee_data are done, in any order
+          const uint32_t lo = ee->ee_info;
+          const uint32_t span = ee->ee_data - lo;
+          std::deque<std::pair<uint32_t, octave_value> >::iterator it
+            = st.zc_pending.begin ();
+          while (it != st.zc_pending.end ())
+            {
+              if (it->first - lo <= span)
+                {
+                  it = st.zc_pending.erase (it);
+                  completed++;
+                  st.stats.zerocopy_completions++;
+                  global_io_stats.zerocopy_completions++;
+                  if (ee->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+                    {
+                      st.stats.zerocopy_copied++;
+                      global_io_stats.zerocopy_copied++;
+                    }
+                }
+              else
+                it++;
+            }
+        }
+    }
+  return completed;
+}
+
+/*
+ * helper function to send NBYTES of BUF, the storage of DATA, over
+ * socket S with MSG_ZEROCOPY.  A copy of DATA is kept until the kernel
+ * reports that it is done with the storage, so that octave can not free
+ * or reuse it; changing the variable makes octave copy it first.
+ * Returns as send.
+ */
+static ssize_t send_zerocopy (int s, const octave_value& data,
+                              const char* buf, size_t nbytes, int flags)
+{
+  socket_state& st = socket_states[s];
+  if (! st.zc_enabled)
+    {
+      // Kernels before 4.14 and other protocols copy as usual
+      const int one = 1;
+      if (setsockopt (s, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof (one)) == -1)
+        {
+          const double t0 = io_clock ();
+          const ssize_t retval = ::send (s, buf, nbytes, flags);
+          count_io (s, IO_SEND, retval, nbytes, t0);
+          return retval;
+        }
+      st.zc_enabled = true;
+    }
+  reap_zerocopy (s);
+
+  const double t0 = io_clock ();
+  const ssize_t retval = ::send (s, buf, nbytes, flags | MSG_ZEROCOPY);
+  count_io (s, IO_SEND, retval, nbytes, t0);
+
+  // The kernel numbers the sends that took any data
+  if (retval > 0)
+    {
+      st.zc_pending.push_back (std::make_pair (st.zc_next_id++, data));
+      st.stats.zerocopy_sends++;
+      global_io_stats.zerocopy_sends++;
+    }
+  return retval;
+}
+#endif
+
+// PKG_ADD: autoload ("send", which ("socket"));
+// PKG_DEL: try; autoload ("send", which ("socket"), "remove"); catch; end;
+// function to send data over a socket
+DEFUN_DLD(send, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {} send (@var{s}, @var{data})\n\
+@deftypefnx {Loadable Function} {} send (@var{s}, @var{data}, @var{flags})\n\
+@deftypefnx {Loadable Function} {} send (@dots{}, \"byteorder\", @var{order})\n\
+@deftypefnx {Loadable Function} {} send (@dots{}, \"zerocopy\", @var{zerocopy})\n\
+Send data on specified socket.\n\
+\n\
+Sends data on socket @var{s}.  @var{data} can be a string or an array of\n\
+any numeric or logical class.  The raw storage of the array is sent in\n\
+column-major order without any conversion, so that for example a double\n\
+matrix with N elements is sent as 8*N bytes.  Complex values are sent as\n\
+interleaved real and imaginary parts.\n\
+\n\
+The byte order of multibyte elements can be chosen with the\n\
+@qcode{\"byteorder\"} option.  @var{order} is one of @qcode{\"native\"}\n\
+(the default), @qcode{\"network\"} or @qcode{\"ieee-be\"} for big endian,\n\
+or @qcode{\"ieee-le\"} for little endian.\n\
+\n\
+If @var{zerocopy} is true, the data is sent with MSG_ZEROCOPY where\n\
+available (Linux), so that the kernel transmits it from the storage of\n\
+the array instead of copying it first.  The array is kept alive until\n\
+the kernel is done with it; @code{send_completions} reports this.  This\n\
+pays off for sends of megabytes, and is ignored for data that has to be\n\
+byte swapped.\n\
+\n\
+The number of bytes sent is returned.\n\
+\n\
+See the @command{send} man pages for further details.\n\
+@seealso{send_completions}\n\
+\n\
+@end deftypefn")
+{
+  if (args.length () < 2)
+  {
+    print_usage ();
+    return octave_value ();
+  }
+
+  io_options opts;
+  get_io_options (args, 2, IO_OPT_BYTEORDER | IO_OPT_ZEROCOPY, opts, "send");
+  if (error_state)
+    return octave_value ();
+
+  // Determine the socket on which to operate
+  const int s = get_socket (args(0));
+  if (error_state)
+    {
+      error ("send: s must be a valid socket");
+      return octave_value ();
+    }
+
+  // Send straight from the storage of the octave variable.  Byte swapped
+  // data needs a copy, which is freed again once sent so that one large
+  // send does not keep its size allocated.
+  std::vector<uint64_t> swapped;
+  size_t nbytes;
+  const char* buf = get_send_data (args(1), opts.swap, swapped, nbytes,
+                                   "send");
+  if (error_state)
+    return octave_value ();
+
+#if defined (SO_ZEROCOPY) && defined (MSG_ZEROCOPY)
+  // Byte swapped data lives in a buffer freed on return
+  const bool was_swapped = ! swapped.empty ()
+    && buf == reinterpret_cast<const char*> (&swapped[0]);
+  if (opts.zerocopy && ! was_swapped)
+    return octave_value (send_zerocopy (s, args(1), buf, nbytes, opts.flags));
+#endif
+
+  const double t0 = io_clock ();
+  const ssize_t retval = ::send (s, buf, nbytes, opts.flags);
+  count_io (s, IO_SEND, retval, nbytes, t0);
+
+  return octave_value (retval);
+}
+
+// PKG_ADD: autoload ("send_completions", which ("socket"));
+// PKG_DEL: try; autoload ("send_completions", which ("socket"), "remove"); catch; end;
+// function to wait for zero-copy sends to complete
+DEFUN_DLD(send_completions, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {[@var{completed}, @var{pending}] =} send_completions (@var{s})\n\
+@deftypefnx {Loadable Function} {[@var{completed}, @var{pending}] =} send_completions (@var{s}, @var{timeout})\n\
+Collect the completions of zero-copy sends.\n\
+\n\
+Reads the notifications of the kernel that it is done with the data of\n\
+sends made on socket @var{s} with the @qcode{\"zerocopy\"} option of\n\
+@code{send}, and releases the arrays that were kept for them.  Returns\n\
+the number of sends @var{completed} now and the number still\n\
+@var{pending}.\n\
+\n\
+With @var{timeout}, waits up to @var{timeout} milliseconds, or forever\n\
+if it is negative, until no send is pending.  The counts of zero-copy\n\
+sends, and of those where the kernel had to copy the data after all,\n\
+are in @code{socket_stats}.\n\
+@seealso{send, socket_stats}\n\
+@end deftypefn")
+{
+  const octave_idx_type nargin = args.length ();
+  if (nargin != 1 && nargin != 2)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  const int s = get_socket (args(0));
+  if (error_state)
+    {
+      error ("send_completions: S must be a valid socket");
+      return octave_value ();
+    }
+
+  int timeout = 0;
+  if (nargin > 1)
+    {
+      timeout = args(1).int_value ();
+      if (error_state)
+        {
+          error ("send_completions: TIMEOUT must be an integer number of milliseconds");
+          return octave_value ();
+        }
+    }
+
+  octave_idx_type completed = 0;
+  octave_idx_type pending = 0;
+#if defined (SO_ZEROCOPY) && defined (MSG_ZEROCOPY)
+  // The error queue makes the socket report POLLERR
+  const double deadline = timeout < 0 ? -1 : monotonic_time () + timeout * 1e-3;
+  for (;;)
+    {
+      completed += reap_zerocopy (s);
+      std::map<int, socket_state>::const_iterator it = socket_states.find (s);
+      pending = (it == socket_states.end () ? 0 : it->second.zc_pending.size ());
+      if (pending == 0)
+        break;
+
+      const int slice_ms = wait_slice_ms (deadline);
+      struct pollfd pfd;
+      pfd.fd = s;
+      pfd.events = 0;
+      pfd.revents = 0;
+      const int rc = ::poll (&pfd, 1, slice_ms);
+      if (rc == -1 && errno != EINTR)
+        {
+          error ("send_completions: poll failed with error %i (%s)", errno,
+                 strerror(errno));
+          return octave_value ();
+        }
+      else if ((rc == 0 && slice_ms == 0) || (rc > 0 && (pfd.revents & POLLHUP)))
+        break;
+    }
+#endif
+
+  octave_value_list return_list;
+  return_list(0) = double (completed);
+  return_list(1) = double (pending);
+  return return_list;
+}
+
+// PKG_ADD: autoload ("recv", which ("socket"));
+// PKG_DEL: try; autoload ("recv", which ("socket"), "remove"); catch; end;
+// function to receive data over a socket
+DEFUN_DLD(recv, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {[@var{data}, @var{count}] =} recv (@var{s}, @var{len})\n\
+@deftypefnx {Loadable Function} {[@var{data}, @var{count}] =} recv (@var{s}, @var{len}, @var{flags})\n\
+@deftypefnx {Loadable Function} {[@var{data}, @var{count}] =} recv (@dots{}, @var{property}, @var{value}, @dots{})\n\
+Read data from specified socket.\n\
+\n\
+Requests reading @var{len} bytes from the socket @var{s}.\n\
+The optional integer @var{flags} parameter can be used to modify the\n\
+behaviour of @code{recv}.\n\
+\n\
+The read data is returned in the uint8 array @var{data}.  The number of\n\
+bytes read is returned in @var{count}.\n\
+\n\
+The data is received directly into the returned array.  Its class and\n\
+shape can be chosen with the following properties:\n\
+\n\
+@table @asis\n\
+@item @qcode{\"class\"}\n\
+The class of @var{data}, one of @qcode{\"uint8\"} (the default),\n\
+@qcode{\"int8\"}, @qcode{\"uint16\"}, @qcode{\"int16\"}, @qcode{\"uint32\"},\n\
+@qcode{\"int32\"}, @qcode{\"uint64\"}, @qcode{\"int64\"}, @qcode{\"single\"},\n\
+@qcode{\"double\"}, @qcode{\"char\"} or @qcode{\"logical\"}.  @var{len} must\n\
+be a multiple of the element size.\n\
+\n\
+@item @qcode{\"dims\"}\n\
+The dimensions of @var{data}.  By default a row vector is returned.  If\n\
+@var{len} is empty it is computed from the dimensions, otherwise it must\n\
+match them.\n\
+\n\
+@item @qcode{\"byteorder\"}\n\
+The byte order of the received elements, as for @code{send}.\n\
+@end table\n\
+\n\
+If fewer than @var{len} bytes are available, @var{data} is a row vector\n\
+holding the complete elements received.  Use @code{MSG_WAITALL} to wait\n\
+for the whole array.  @var{count} is the size in bytes of @var{data}.\n\
+The bytes of an incomplete last element are not lost: on stream sockets\n\
+the next @code{recv}, @code{recvall} or @code{recvfrom} returns them\n\
+first.  If no complete element was received, -1 is returned in\n\
+@var{count}.\n\
+\n\
+You can get non-blocking operation by using the flag @code{MSG_DONTWAIT}\n\
+which makes the @code{recv()} call return immediately.  If there is no\n\
+data, -1 is returned in count.\n\
+\n\
+See the @command{recv} man pages for further details.\n\
+\n\
+@end deftypefn")
+{
+  if (args.length () < 2)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  io_options opts;
+  get_io_options (args, 2, IO_OPT_BYTEORDER | IO_OPT_CLASS | IO_OPT_DIMS,
+                  opts, "recv");
+  if (error_state)
+    return octave_value ();
+
+  // Determine the socket on which to operate
+  const int s = get_socket (args(0));
+  if (error_state)
+    {
+      error ("recv: S must be a valid socket");
+      return octave_value ();
+    }
+
+  const octave_idx_type len = get_recv_len (args(1), opts, "recv");
+  if (error_state)
+    return octave_value (-1);
+
+  // Receive straight into the storage of the returned array, after
+  // what the last receive left over
+  recv_array data (opts.cls, opts.dv);
+  char* const buf = data.data ();
+  const size_t done = take_recv_rest (s, buf, len, opts.flags);
+  ssize_t retval = done;
+  if (done < size_t (len))
+    {
+      const double t0 = io_clock ();
+      const ssize_t n = ::recv (s, buf + done, len - done, opts.flags);
+      count_io (s, IO_RECV, n, len - done, t0);
+      if (n > 0 || done == 0)
+        retval = ssize_t (done) + n;
+    }
+
+  if (retval == -1)
+    warning ("recv error %i (%s)", errno, strerror(errno));
+
+  octave_value_list return_list;
+
+  // We get -1 if an error occurs, or if there is no data and the
+  // socket is non-blocking. We get 0 if the peer has shut down.
+  // Always return the status in the second output parameter.
+  const bool got_bytes = (retval > 0);
+  return_list(0) = finish_recv_data (data, retval, len, opts, s);
+  if (got_bytes && retval == 0)
+    retval = -1;
+  return_list(1) = retval;
+  return return_list;
+}
+
+// PKG_ADD: autoload ("sendall", which ("socket"));
+// PKG_DEL: try; autoload ("sendall", which ("socket"), "remove"); catch; end;
+// function to send all data over a socket
+DEFUN_DLD(sendall, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {@var{count} =} sendall (@var{s}, @var{data})\n\
+@deftypefnx {Loadable Function} {@var{count} =} sendall (@var{s}, @var{data}, @var{flags})\n\
+@deftypefnx {Loadable Function} {@var{count} =} sendall (@dots{}, @var{property}, @var{value}, @dots{})\n\
+Send all data on specified socket.\n\
+\n\
+Like @code{send}, but keeps sending until all of @var{data} has been\n\
+sent, also on non-blocking sockets.  Interrupted and partial writes are\n\
+retried, and Ctrl-C is honoured while waiting for the socket.\n\
+\n\
+The @qcode{\"byteorder\"} property is the same as for @code{send}.  The\n\
+@qcode{\"timeout\"} property sets the maximum time in seconds to wait\n\
+for the whole transfer.  The number of bytes sent is returned, which is\n\
+less than the size of @var{data} only if the timeout expired.\n\
+\n\
+@seealso{send, recvall}\n\
+@end deftypefn")
+{
+  if (args.length () < 2)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  io_options opts;
+  get_io_options (args, 2, IO_OPT_BYTEORDER | IO_OPT_TIMEOUT, opts,
+                  "sendall");
+  if (error_state)
+    return octave_value ();
+
+  // Determine the socket on which to operate
+  const int s = get_socket (args(0));
+  if (error_state)
+    {
+      error ("sendall: S must be a valid socket");
+      return octave_value ();
+    }
+
+  std::vector<uint64_t> swapped;
+  size_t nbytes;
+  const char* buf = get_send_data (args(1), opts.swap, swapped, nbytes,
+                                   "sendall");
+  if (error_state)
+    return octave_value ();
+
+  const ssize_t retval = transfer_all (s, const_cast<char*> (buf), nbytes,
+                                       true, opts.flags, opts.deadline);
+  if (retval == -1)
+    error ("sendall failed with error %i (%s)", errno, strerror(errno));
+
+  return octave_value (retval);
+}
+
+#ifndef __WIN32__
+// a dead subscriber must not kill octave with SIGPIPE
+#ifdef MSG_NOSIGNAL
+static const int fanout_flags = MSG_DONTWAIT | MSG_NOSIGNAL;
+#else
+static const int fanout_flags = MSG_DONTWAIT;
+#endif
+
+/*
+ * helper function to write as much of the queue of socket S as it
+ * takes without blocking.  Returns false with errno set if the socket
+ * failed, after dropping its queue.
+ */
+static bool flush_out_queue (int s)
+{
+  socket_state& st = socket_states[s];
+  while (! st.out_queue.empty ())
+    {
+      out_chunk& c = st.out_queue.front ();
+      const size_t want = c.len - c.off;
+      const double t0 = io_clock ();
+      const ssize_t n = ::send (s, c.buf + c.off, want, c.flags | fanout_flags);
+      count_io (s, IO_SEND, n, want, t0);
+      if (n == -1)
+        {
+          if (errno == EINTR)
+            continue;
+          else if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return true;
+          const int err = errno;
+          st.out_queue.clear ();
+          st.out_queued = 0;
+          errno = err;
+          return false;
+        }
+      c.off += n;
+      st.out_queued -= n;
+      if (c.off == c.len)
+        st.out_queue.pop_front ();
+    }
+  return true;
+}
+
+// PKG_ADD: autoload ("send_multi", which ("socket"));
+// PKG_DEL: try; autoload ("send_multi", which ("socket"), "remove"); catch; end;
+// function to send the same data to many sockets
+DEFUN_DLD(send_multi, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {[@var{sent}, @var{queued}] =} send_multi (@var{fds}, @var{data})\n\
+@deftypefnx {Loadable Function} {[@var{sent}, @var{queued}] =} send_multi (@var{fds}, @var{data}, @var{flags})\n\
+@deftypefnx {Loadable Function} {[@var{sent}, @var{queued}] =} send_multi (@dots{}, @var{property}, @var{value}, @dots{})\n\
+Send the same data to many sockets.\n\
+\n\
+Sends @var{data}, an array as accepted by @code{send}, to each stream\n\
+socket in the array or cell array @var{fds}, converting it only once.\n\
+The sockets are written without blocking, and what a socket does not\n\
+take at once is queued for it, sharing the storage of @var{data}.  The\n\
+queue is written first by the next @code{send_multi} to the socket, or\n\
+by @code{send_multi_flush}, so slow receivers do not hold up the others\n\
+and get the data in order.  Other functions sending on the socket do\n\
+not wait for its queue.\n\
+\n\
+@var{sent} has the size of @var{fds} and holds the number of bytes of\n\
+@var{data} sent to each socket now, or the negative error number if the\n\
+socket failed, which drops its queue.  @var{queued} holds the number of\n\
+bytes still queued for each socket.\n\
+\n\
+The @qcode{\"byteorder\"} property is the same as for @code{send}.  The\n\
+@qcode{\"max_queue\"} property limits the bytes queued per socket: a\n\
+socket that would exceed it does not get @var{data} at all, which is\n\
+reported as @code{-ENOBUFS}, so that a stalled receiver skips data\n\
+instead of exhausting memory.\n\
+@seealso{send, send_multi_flush, poll}\n\
+@end deftypefn")
+{
+  if (args.length () < 2)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  io_options opts;
+  get_io_options (args, 2, IO_OPT_BYTEORDER | IO_OPT_MAX_QUEUE, opts,
+                  "send_multi");
+  if (error_state)
+    return octave_value ();
+
+  const Array<int> fds = get_socket_array (args(0));
+  if (error_state)
+    {
+      error ("send_multi: FDS must be an array or a cell array of sockets");
+      return octave_value ();
+    }
+
+  // Byte swapped data gets storage of its own that the queues can share
+  std::vector<uint64_t> swapped;
+  size_t nbytes;
+  const char* buf = get_send_data (args(1), opts.swap, swapped, nbytes,
+                                   "send_multi");
+  if (error_state)
+    return octave_value ();
+  octave_value payload = args(1);
+  if (! swapped.empty ())
+    {
+      uint8NDArray copy (dim_vector (nbytes, 1));
+      memcpy (copy.fortran_vec (), buf, nbytes);
+      payload = copy;
+      buf = static_cast<const char*> (payload.mex_get_data ());
+    }
+
+  NDArray sent (fds.dims ());
+  NDArray queued (fds.dims ());
+  for (octave_idx_type i = 0; i < fds.numel (); i++)
+    {
+      const int s = fds(i);
+      socket_state& st = socket_states[s];
+      size_t done = 0;
+      int err = 0;
+      if (! flush_out_queue (s))
+        err = errno;
+      else if (st.out_queued + nbytes > opts.max_queue)
+        err = ENOBUFS;
+
+      // Write directly only behind an empty queue
+      while (err == 0 && st.out_queue.empty () && done < nbytes)
+        {
+          const double t0 = io_clock ();
+          const ssize_t n = ::send (s, buf + done, nbytes - done,
+                                    opts.flags | fanout_flags);
+          count_io (s, IO_SEND, n, nbytes - done, t0);
+          if (n >= 0)
+            done += n;
+          else if (errno == EAGAIN || errno == EWOULDBLOCK)
+            break;
+          else if (errno != EINTR)
+            err = errno;
+        }
+
+      if (err == 0 && done < nbytes)
+        {
+          out_chunk c;
+          c.data = payload;
+          c.buf = buf;
+          c.off = done;
+          c.len = nbytes;
+          c.flags = opts.flags;
+          st.out_queue.push_back (c);
+          st.out_queued += nbytes - done;
+        }
+
+      sent(i) = err ? -err : double (done);
+      queued(i) = st.out_queued;
+    }
+
+  octave_value_list return_list;
+  return_list(0) = sent;
+  return_list(1) = queued;
+  return return_list;
+}
+
+// PKG_ADD: autoload ("send_multi_flush", which ("socket"));
+// PKG_DEL: try; autoload ("send_multi_flush", which ("socket"), "remove"); catch; end;
+// function to write the data queued by send_multi
+DEFUN_DLD(send_multi_flush, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {@var{queued} =} send_multi_flush (@var{fds})\n\
+@deftypefnx {Loadable Function} {@var{queued} =} send_multi_flush (@var{fds}, @var{timeout})\n\
+Write the data queued by @code{send_multi}.\n\
+\n\
+Writes what the sockets in the array or cell array @var{fds} take of\n\
+their queues without blocking, and returns the number of bytes still\n\
+queued for each, or the negative error number if the socket failed.\n\
+\n\
+With @var{timeout}, waits up to @var{timeout} milliseconds, or forever\n\
+if it is negative, until all queues are written.\n\
+@seealso{send_multi}\n\
+@end deftypefn")
+{
+  const octave_idx_type nargin = args.length ();
+  if (nargin != 1 && nargin != 2)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  const Array<int> fds = get_socket_array (args(0));
+  if (error_state)
+    {
+      error ("send_multi_flush: FDS must be an array or a cell array of sockets");
+      return octave_value ();
+    }
+  const octave_idx_type n = fds.numel ();
+
+  int timeout = 0;
+  if (nargin > 1)
+    {
+      timeout = args(1).int_value ();
+      if (error_state)
+        {
+          error ("send_multi_flush: TIMEOUT must be an integer number of milliseconds");
+          return octave_value ();
+        }
+    }
+
+  NDArray queued (fds.dims (), 0);
+  std::vector<struct pollfd> pfds;
+  std::vector<octave_idx_type> idx;
+  const double deadline = timeout < 0 ? -1 : monotonic_time () + timeout * 1e-3;
+  for (;;)
+    {
+      pfds.clear ();
+      idx.clear ();
+      for (octave_idx_type i = 0; i < n; i++)
+        {
+          if (queued(i) < 0)
+            continue;
+          if (! flush_out_queue (fds(i)))
+            queued(i) = -errno;
+          else
+            {
+              queued(i) = socket_states[fds(i)].out_queued;
+              if (queued(i) > 0)
+                {
+                  struct pollfd pfd;
+                  pfd.fd = fds(i);
+                  pfd.events = POLLOUT;
+                  pfd.revents = 0;
+                  pfds.push_back (pfd);
+                  idx.push_back (i);
+                }
+            }
+        }
+      if (pfds.empty ())
+        break;
+
+      const int slice_ms = wait_slice_ms (deadline);
+      if (slice_ms == 0)
+        break;
+      if (::poll (&pfds[0], pfds.size (), slice_ms) == -1 && errno != EINTR)
+        {
+          error ("send_multi_flush: poll failed with error %i (%s)", errno,
+                 strerror(errno));
+          return octave_value ();
+        }
+    }
+
+  return octave_value (queued);
+}
+#else
+DEFUNX_DLD ("send_multi", Fsend_multi, Gsend_multi, args, nargout, "(not supported)")
+{ error( "send_multi: not supported on this platform" );
+  return octave_value(); };
+DEFUNX_DLD ("send_multi_flush", Fsend_multi_flush, Gsend_multi_flush, args, nargout, "(not supported)")
+{ error( "send_multi_flush: not supported on this platform" );
+  return octave_value(); };
+#endif
+
+// PKG_ADD: autoload ("recvall", which ("socket"));
+// PKG_DEL: try; autoload ("recvall", which ("socket"), "remove"); catch; end;
+// function to receive a given amount of data over a socket
+DEFUN_DLD(recvall, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {[@var{data}, @var{count}] =} recvall (@var{s}, @var{len})\n\
+@deftypefnx {Loadable Function} {[@var{data}, @var{count}] =} recvall (@var{s}, @var{len}, @var{flags})\n\
+@deftypefnx {Loadable Function} {[@var{data}, @var{count}] =} recvall (@dots{}, @var{property}, @var{value}, @dots{})\n\
+Read a given amount of data from specified socket.\n\
+\n\
+Like @code{recv}, but keeps reading until all @var{len} bytes have been\n\
+received, also on non-blocking sockets.  Interrupted and partial reads\n\
+are retried, and Ctrl-C is honoured while waiting for the socket.\n\
+\n\
+The @qcode{\"class\"}, @qcode{\"dims\"} and @qcode{\"byteorder\"}\n\
+properties are the same as for @code{recv}.  The @qcode{\"timeout\"}\n\
+property sets the maximum time in seconds to wait for the whole\n\
+transfer.  @var{count} is less than @var{len} only if the timeout\n\
+expired or the peer shut down the connection, in which case @var{data}\n\
+is a row vector of the complete elements received and the bytes of an\n\
+incomplete last element are kept for the next receive, as for\n\
+@code{recv}.\n\
+\n\
+@seealso{recv, sendall}\n\
+@end deftypefn")
+{
+  if (args.length () < 2)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  io_options opts;
+  get_io_options (args, 2, IO_OPT_BYTEORDER | IO_OPT_CLASS | IO_OPT_DIMS
+                  | IO_OPT_TIMEOUT, opts, "recvall");
+  if (error_state)
+    return octave_value ();
+
+  // Determine the socket on which to operate
+  const int s = get_socket (args(0));
+  if (error_state)
+    {
+      error ("recvall: S must be a valid socket");
+      return octave_value ();
+    }
+
+  const octave_idx_type len = get_recv_len (args(1), opts, "recvall");
+  if (error_state)
+    return octave_value ();
+
+  recv_array data (opts.cls, opts.dv);
+  char* const buf = data.data ();
+  const size_t done = take_recv_rest (s, buf, len, opts.flags);
+  ssize_t retval = transfer_all (s, buf + done, len - done, false,
+                                 opts.flags, opts.deadline);
+  if (retval == -1)
+    {
+      error ("recvall failed with error %i (%s)", errno, strerror(errno));
+      return octave_value ();
+    }
+  retval += done;
+
+  octave_value_list return_list;
+  return_list(0) = finish_recv_data (data, retval, len, opts, s);
+  return_list(1) = retval;
+  return return_list;
+}
+
+// PKG_ADD: autoload ("sendto", which ("socket"));
+// PKG_DEL: try; autoload ("sendto", which ("socket"), "remove"); catch; end;
+// function to send a datagram to a given address
+DEFUN_DLD(sendto, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {@var{count} =} sendto (@var{s}, @var{data}, @var{addr})\n\
+@deftypefnx {Loadable Function} {@var{count} =} sendto (@var{s}, @var{data}, @var{addr}, @var{flags})\n\
+@deftypefnx {Loadable Function} {@var{count} =} sendto (@dots{}, \"byteorder\", @var{order})\n\
+Send data to a given address.\n\
+\n\
+Sends @var{data} on socket @var{s} to the address @var{addr}, which is\n\
+a struct with the fields @code{addr} and @code{port} as for\n\
+@code{connect}.  This is mostly useful for @code{SOCK_DGRAM} sockets,\n\
+where each call sends one datagram.\n\
+\n\
+@var{data} and the @qcode{\"byteorder\"} property are the same as for\n\
+@code{send}.  The number of bytes sent is returned.\n\
+\n\
+See the @command{sendto} man pages for further details.\n\
+@seealso{recvfrom, sendmmsg, send}\n\
+@end deftypefn")
+{
+  if (args.length () < 3)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  io_options opts;
+  get_io_options (args, 3, IO_OPT_BYTEORDER, opts, "sendto");
+  if (error_state)
+    return octave_value ();
+
+  // Determine the socket on which to operate
+  const int s = get_socket (args(0));
+  if (error_state)
+    {
+      error ("sendto: S must be a valid socket");
+      return octave_value ();
+    }
+
+  struct sockaddr_storage addr;
+  const socklen_t addrlen = get_sockaddr (args(2), socket_family (s), addr,
+                                          "sendto", "ADDR");
+  if (error_state)
+    return octave_value ();
+
+  std::vector<uint64_t> swapped;
+  size_t nbytes;
+  const char* buf = get_send_data (args(1), opts.swap, swapped, nbytes,
+                                   "sendto");
+  if (error_state)
+    return octave_value ();
+
+  const double t0 = io_clock ();
+  const ssize_t retval = ::sendto (s, buf, nbytes, opts.flags,
+                                   (struct sockaddr*)&addr, addrlen);
+  count_io (s, IO_SEND, retval, nbytes, t0);
+  if (retval == -1)
+    error ("sendto failed with error %i (%s)", errno, strerror(errno));
+
+  return octave_value (retval);
+}
+
+// PKG_ADD: autoload ("recvfrom", which ("socket"));
+// PKG_DEL: try; autoload ("recvfrom", which ("socket"), "remove"); catch; end;
+// function to receive a datagram and its source address
+DEFUN_DLD(recvfrom, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {[@var{data}, @var{count}, @var{from}] =} recvfrom (@var{s}, @var{len})\n\
+@deftypefnx {Loadable Function} {[@var{data}, @var{count}, @var{from}] =} recvfrom (@var{s}, @var{len}, @var{flags})\n\
+@deftypefnx {Loadable Function} {[@var{data}, @var{count}, @var{from}] =} recvfrom (@dots{}, @var{property}, @var{value}, @dots{})\n\
+Read data and its source address from specified socket.\n\
+\n\
+Like @code{recv}, but also returns the address the data was sent from\n\
+in @var{from}, a struct with the fields @code{addr} and @code{port} that\n\
+can be passed to @code{sendto} to reply.  For @code{SOCK_DGRAM}\n\
+sockets, each call reads one datagram.  A datagram longer than\n\
+@var{len} bytes is truncated, and the bytes of an incomplete last\n\
+element of a datagram are dropped.\n\
+\n\
+The optional arguments are the same as for @code{recv}.\n\
+\n\
+See the @command{recvfrom} man pages for further details.\n\
+@seealso{sendto, recvmmsg, recv}\n\
+@end deftypefn")
+{
+  if (args.length () < 2)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  io_options opts;
+  get_io_options (args, 2, IO_OPT_BYTEORDER | IO_OPT_CLASS | IO_OPT_DIMS,
+                  opts, "recvfrom");
+  if (error_state)
+    return octave_value ();
+
+  // Determine the socket on which to operate
+  const int s = get_socket (args(0));
+  if (error_state)
+    {
+      error ("recvfrom: S must be a valid socket");
+      return octave_value ();
+    }
+
+  const octave_idx_type len = get_recv_len (args(1), opts, "recvfrom");
+  if (error_state)
+    return octave_value (-1);
+
+  recv_array data (opts.cls, opts.dv);
+  char* const buf = data.data ();
+  const size_t done = take_recv_rest (s, buf, len, opts.flags);
+  struct sockaddr_storage from;
+  memset (&from, 0, sizeof (from));
+  socklen_t fromlen = sizeof (from);
+  ssize_t n = -1;
+  ssize_t retval = done;
+  if (done < size_t (len))
+    {
+      const double t0 = io_clock ();
+#ifndef __WIN32__
+      n = ::recvfrom (s, buf + done, len - done, opts.flags,
+                      (struct sockaddr*)&from, &fromlen);
+#else
+      n = ::recvfrom (s, buf + done, len - done, opts.flags,
+                      (struct sockaddr*)&from, (int*)&fromlen);
+#endif
+      count_io (s, IO_RECV, n, len - done, t0);
+      if (n > 0 || done == 0)
+        retval = ssize_t (done) + n;
+    }
+
+  if (retval == -1)
+    warning ("recvfrom error %i (%s)", errno, strerror(errno));
+
+  octave_value_list return_list;
+  const bool got_bytes = (retval > 0);
+  return_list(0) = finish_recv_data (data, retval, len, opts, s);
+  if (got_bytes && retval == 0)
+    retval = -1;
+  return_list(1) = retval;
+  if (n >= 0)
+    return_list(2) = sockaddr_to_map (from);
+  else
+    return_list(2) = octave_scalar_map ();
+  return return_list;
+}
+
+// PKG_ADD: autoload ("sendmmsg", which ("socket"));
+// PKG_DEL: try; autoload ("sendmmsg", which ("socket"), "remove"); catch; end;
+// function to send many datagrams at once
+#ifdef __linux__
+DEFUN_DLD(sendmmsg, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {@var{count} =} sendmmsg (@var{s}, @var{msgs})\n\
+@deftypefnx {Loadable Function} {@var{count} =} sendmmsg (@var{s}, @var{msgs}, @var{addr})\n\
+@deftypefnx {Loadable Function} {@var{count} =} sendmmsg (@var{s}, @var{msgs}, @var{addr}, @var{flags})\n\
+Send many datagrams at once.\n\
+\n\
+Sends each element of the cell array @var{msgs} as a separate datagram\n\
+on socket @var{s}, passing as many as possible to the kernel in each\n\
+system call.  The elements can be anything accepted by @code{send}, and\n\
+are sent from their storage without copying.\n\
+\n\
+@var{addr} is either a single address struct as for @code{sendto}, used\n\
+for all datagrams, or a struct array with one address per datagram.  If\n\
+it is empty or not given, the socket must be connected.\n\
+\n\
+The number of datagrams sent is returned.  It is less than\n\
+@code{numel (@var{msgs})} only if a non-blocking socket ran out of\n\
+buffer space.\n\
+\n\
+See the @command{sendmmsg} man pages for further details.\n\
+@seealso{recvmmsg, sendto}\n\
+@end deftypefn")
+{
+  const octave_idx_type nargin = args.length ();
+
+  if (nargin < 2 || nargin > 4)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  // Determine the socket on which to operate
+  const int s = get_socket (args(0));
+  if (error_state)
+    {
+      error ("sendmmsg: S must be a valid socket");
+      return octave_value ();
+    }
+
+  const Cell msgs = args(1).cell_value ();
+  if (error_state)
+    {
+      error ("sendmmsg: MSGS must be a cell array");
+      return octave_value ();
+    }
+  const octave_idx_type n = msgs.numel ();
+
+  int flags = 0;
+  if (nargin > 3)
+    {
+      flags = args(3).int_value ();
+      if (error_state)
+        {
+          error ("sendmmsg: FLAGS must be a scalar integer");
+          return octave_value ();
+        }
+    }
+
+  // One address for all datagrams, one per datagram, or none
+  std::vector<struct sockaddr_storage> addrs;
+  std::vector<socklen_t> addrlens;
+  if (nargin > 2 && ! args(2).is_empty ())
+    {
+      const octave_map addr_map = args(2).map_value ();
+      if (error_state
+          || (addr_map.numel () != 1 && addr_map.numel () != n))
+        {
+          error ("sendmmsg: ADDR must be a struct or a struct array matching MSGS");
+          return octave_value ();
+        }
+      const int family = socket_family (s);
+      addrs.resize (addr_map.numel ());
+      addrlens.resize (addr_map.numel ());
+      for (octave_idx_type i = 0; i < addr_map.numel (); i++)
+        {
+          addrlens[i] = get_sockaddr (octave_value (addr_map(i)), family,
+                                      addrs[i], "sendmmsg", "ADDR");
+          if (error_state)
+            return octave_value ();
+        }
+    }
+
+  std::vector<struct mmsghdr> hdrs (n);
+  std::vector<struct iovec> iov (n);
+  std::vector<std::vector<uint64_t> > expanded (n);
+  for (octave_idx_type i = 0; i < n; i++)
+    {
+      size_t nbytes;
+      const char* buf = get_send_data (msgs(i), false, expanded[i], nbytes,
+                                       "sendmmsg");
+      if (! buf)
+        return octave_value ();
+      iov[i].iov_base = const_cast<char*> (buf);
+      iov[i].iov_len = nbytes;
+
+      memset (&hdrs[i], 0, sizeof (hdrs[i]));
+      hdrs[i].msg_hdr.msg_iov = &iov[i];
+      hdrs[i].msg_hdr.msg_iovlen = 1;
+      if (! addrs.empty ())
+        {
+          const size_t j = addrs.size () == 1 ? 0 : i;
+          hdrs[i].msg_hdr.msg_name = &addrs[j];
+          hdrs[i].msg_hdr.msg_namelen = addrlens[j];
+        }
+    }
+
+  // The kernel may take fewer datagrams than given per call
+  octave_idx_type sent = 0;
+  while (sent < n)
+    {
+      octave_quit ();
+
+      const double t0 = io_clock ();
+      const int rc = ::sendmmsg (s, &hdrs[sent], n - sent, flags);
+      count_call (s, IO_SEND, rc < 0, rc >= 0 && rc < n - sent, t0);
+      if (rc > 0)
+        {
+          for (int i = 0; i < rc; i++)
+            count_bytes (s, hdrs[sent + i].msg_len, true);
+          sent += rc;
+        }
+      else if (rc == -1 && errno == EINTR)
+        continue;
+      else if (rc == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        break;
+      else
+        {
+          error ("sendmmsg failed with error %i (%s)", errno, strerror(errno));
+          return octave_value ();
+        }
+    }
+
+  return octave_value (sent);
+}
+#else
+DEFUNX_DLD ("sendmmsg", Fsendmmsg, Gsendmmsg, args, nargout, "(not supported)")
+{ error( "sendmmsg: not supported on this platform" );
+  return octave_value(); };
+#endif
+
+// PKG_ADD: autoload ("recvmmsg", which ("socket"));
+// PKG_DEL: try; autoload ("recvmmsg", which ("socket"), "remove"); catch; end;
+// function to receive many datagrams at once
+#ifdef __linux__
+DEFUN_DLD(recvmmsg, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {[@var{data}, @var{lens}, @var{from}] =} recvmmsg (@var{s}, @var{n}, @var{len})\n\
+@deftypefnx {Loadable Function} {[@var{data}, @var{lens}, @var{from}] =} recvmmsg (@var{s}, @var{n}, @var{len}, @var{flags})\n\
+Receive many datagrams at once.\n\
+\n\
+Waits for a datagram on socket @var{s} and then receives up to @var{n}\n\
+datagrams of at most @var{len} bytes each in a single system call.\n\
+\n\
+The datagrams are received directly into the columns of the uint8\n\
+matrix @var{data}, which has @var{len} rows and one column per datagram\n\
+received.  The length of each datagram is returned in the row vector\n\
+@var{lens}, and its source address in the struct array @var{from}.\n\
+Longer datagrams are truncated to @var{len} bytes.\n\
+\n\
+With @code{MSG_DONTWAIT} in @var{flags}, @code{recvmmsg} does not wait\n\
+and returns empty outputs if no datagram is available.\n\
+\n\
+See the @command{recvmmsg} man pages for further details.\n\
+@seealso{sendmmsg, recvfrom}\n\
+@end deftypefn")
+{
+  const octave_idx_type nargin = args.length ();
+
+  if (nargin < 3 || nargin > 4)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  // Determine the socket on which to operate
+  const int s = get_socket (args(0));
+  if (error_state)
+    {
+      error ("recvmmsg: S must be a valid socket");
+      return octave_value ();
+    }
+
+  const octave_idx_type n = args(1).idx_type_value ();
+  const octave_idx_type len = args(2).idx_type_value ();
+  if (error_state || n < 1 || len < 0)
+    {
+      error ("recvmmsg: N must be a positive and LEN a non-negative integer");
+      return octave_value ();
+    }
+
+  int flags = 0;
+  if (nargin > 3)
+    {
+      flags = args(3).int_value ();
+      if (error_state)
+        {
+          error ("recvmmsg: FLAGS must be a scalar integer");
+          return octave_value ();
+        }
+    }
+
+  uint8NDArray data (dim_vector (len, n));
+  char* buf = reinterpret_cast<char*> (data.fortran_vec ());
+  std::vector<struct mmsghdr> hdrs (n);
+  std::vector<struct iovec> iov (n);
+  std::vector<struct sockaddr_storage> addrs (n);
+  for (octave_idx_type i = 0; i < n; i++)
+    {
+      iov[i].iov_base = buf + i * len;
+      iov[i].iov_len = len;
+
+      memset (&hdrs[i], 0, sizeof (hdrs[i]));
+      hdrs[i].msg_hdr.msg_iov = &iov[i];
+      hdrs[i].msg_hdr.msg_iovlen = 1;
+      hdrs[i].msg_hdr.msg_name = &addrs[i];
+      hdrs[i].msg_hdr.msg_namelen = sizeof (struct sockaddr_storage);
+    }
+
+  // Wait for the first datagram, and take whatever else is queued
+  int k = -1;
+  do
+    {
+      if (! (flags & MSG_DONTWAIT) && wait_socket (s, false, -1) == -1)
+        break;
+      const double t0 = io_clock ();
+      k = ::recvmmsg (s, &hdrs[0], n, flags | MSG_WAITFORONE, 0);
+      count_call (s, IO_RECV, k < 0, k >= 0 && k < n, t0);
+    }
+  while (k == -1 && (errno == EINTR
+                     || ((errno == EAGAIN || errno == EWOULDBLOCK)
+                         && ! (flags & MSG_DONTWAIT))));
+  if (k == -1 && errno != EAGAIN && errno != EWOULDBLOCK)
+    {
+      error ("recvmmsg failed with error %i (%s)", errno, strerror(errno));
+      return octave_value ();
+    }
+  if (k < 0)
+    k = 0;
+
+  if (k < n)
+    data.resize (dim_vector (len, k));
+
+  RowVector lens (k);
+  Cell from_addr (dim_vector (1, k));
+  Cell from_port (dim_vector (1, k));
+  for (int i = 0; i < k; i++)
+    {
+      lens(i) = hdrs[i].msg_len;
+      count_bytes (s, hdrs[i].msg_len, false);
+      const octave_scalar_map from = sockaddr_to_map (addrs[i]);
+      from_addr(i) = from.getfield ("addr");
+      from_port(i) = from.getfield ("port");
+    }
+  octave_map from (dim_vector (1, k));
+  from.assign ("addr", from_addr);
+  from.assign ("port", from_port);
+
+  octave_value_list return_list;
+  return_list(0) = data;
+  return_list(1) = lens;
+  return_list(2) = from;
+  return return_list;
+}
+#else
+DEFUNX_DLD ("recvmmsg", Frecvmmsg, Grecvmmsg, args, nargout, "(not supported)")
+{ error( "recvmmsg: not supported on this platform" );
+  return octave_value(); };
+#endif
+
+// PKG_ADD: autoload ("send_msg", which ("socket"));
+// PKG_DEL: try; autoload ("send_msg", which ("socket"), "remove"); catch; end;
+// function to send a length prefixed message
+DEFUN_DLD(send_msg, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {@var{count} =} send_msg (@var{s}, @var{data})\n\
+@deftypefnx {Loadable Function} {@var{count} =} send_msg (@var{s}, @var{data}, @var{flags})\n\
+@deftypefnx {Loadable Function} {@var{count} =} send_msg (@dots{}, @var{property}, @var{value}, @dots{})\n\
+Send a message on specified socket.\n\
+\n\
+Sends @var{data} on the stream socket @var{s} as one message, preceded by\n\
+its length in bytes as a 4 byte unsigned integer in network byte order.\n\
+The receiver gets the message back in one piece with @code{recv_msg}.\n\
+Messages must be smaller than 4 GiB.\n\
+\n\
+@var{data} and the @qcode{\"byteorder\"} and @qcode{\"timeout\"}\n\
+properties are the same as for @code{sendall}.  The whole message is\n\
+sent, and the number of bytes of @var{data} sent is returned.\n\
+@seealso{recv_msg, sendall}\n\
+@end deftypefn")
+{
+  if (args.length () < 2)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  io_options opts;
+  get_io_options (args, 2, IO_OPT_BYTEORDER | IO_OPT_TIMEOUT, opts,
+                  "send_msg");
+  if (error_state)
+    return octave_value ();
+
+  // Determine the socket on which to operate
+  const int s = get_socket (args(0));
+  if (error_state)
+    {
+      error ("send_msg: S must be a valid socket");
+      return octave_value ();
+    }
+
+  std::vector<uint64_t> swapped;
+  size_t nbytes;
+  const char* buf = get_send_data (args(1), opts.swap, swapped, nbytes,
+                                   "send_msg");
+  if (error_state)
+    return octave_value ();
+  if (nbytes > 0xffffffffu)
+    {
+      error ("send_msg: DATA must be smaller than 4 GiB");
+      return octave_value ();
+    }
+
+  // Send the header and the data without copying them together
+  uint32_t header = htonl (uint32_t (nbytes));
+  struct iovec iov[2];
+  iov[0].iov_base = &header;
+  iov[0].iov_len = sizeof (header);
+  iov[1].iov_base = const_cast<char*> (buf);
+  iov[1].iov_len = nbytes;
+
+  const ssize_t retval = send_all_iov (s, iov, 2, opts.flags, opts.deadline);
+  if (retval == -1)
+    {
+      error ("send_msg failed with error %i (%s)", errno, strerror(errno));
+      return octave_value ();
+    }
+  else if (size_t (retval) < sizeof (header) + nbytes)
+    {
+      error ("send_msg: timeout after sending %ld of %ld bytes", long (retval),
+             long (sizeof (header) + nbytes));
+      return octave_value ();
+    }
+
+  return octave_value (nbytes);
+}
+
+// PKG_ADD: autoload ("recv_msg", which ("socket"));
+// PKG_DEL: try; autoload ("recv_msg", which ("socket"), "remove"); catch; end;
+// function to receive a length prefixed message
+DEFUN_DLD(recv_msg, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {[@var{data}, @var{count}] =} recv_msg (@var{s})\n\
+@deftypefnx {Loadable Function} {[@var{data}, @var{count}] =} recv_msg (@var{s}, @var{flags})\n\
+@deftypefnx {Loadable Function} {[@var{data}, @var{count}] =} recv_msg (@dots{}, @var{property}, @var{value}, @dots{})\n\
+Read a message from specified socket.\n\
+\n\
+Reads one complete message sent with @code{send_msg} from the stream\n\
+socket @var{s}.  The message is returned as a row vector in @var{data},\n\
+and its length in bytes in @var{count}.\n\
+\n\
+Data is read ahead in large blocks and kept in a buffer for the socket,\n\
+so that many small messages take few system calls.  Partially received\n\
+messages are kept there as well.  With @code{MSG_DONTWAIT} in\n\
+@var{flags}, or when the @qcode{\"timeout\"} in seconds expires,\n\
+@code{recv_msg} returns an empty @var{data} and -1 in @var{count} if no\n\
+complete message is available yet.  A later call continues where it\n\
+stopped.  -1 is also returned once the peer has shut down the\n\
+connection.  The buffer is released by @code{disconnect}.\n\
+\n\
+Messages longer than the @qcode{\"maxlen\"} property, 64 MiB by default,\n\
+are an error, since the length comes from the peer.  The rest of the\n\
+stream can then not be read as messages.\n\
+\n\
+The @qcode{\"class\"} and @qcode{\"byteorder\"} properties are the same as\n\
+for @code{recv}.\n\
+@seealso{send_msg, recvall}\n\
+@end deftypefn")
+{
+  if (args.length () < 1)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  io_options opts;
+  get_io_options (args, 1, IO_OPT_BYTEORDER | IO_OPT_CLASS | IO_OPT_TIMEOUT
+                  | IO_OPT_MAX_LEN, opts, "recv_msg");
+  if (error_state)
+    return octave_value ();
+
+  // Determine the socket on which to operate
+  const int s = get_socket (args(0));
+  if (error_state)
+    {
+      error ("recv_msg: S must be a valid socket");
+      return octave_value ();
+    }
+
+  msg_reader& r = socket_states[s].reader;
+  if (r.stage.empty ())
+    r.stage.resize (65536);
+  char* const stage = &r.stage[0];
+
+  ssize_t n = 1;
+  // Read the header, keeping whatever follows it in the stage
+  while (! r.have_header)
+    {
+      if (r.stage_end - r.stage_pos >= sizeof (uint32_t))
+        {
+          uint32_t header;
+          memcpy (&header, stage + r.stage_pos, sizeof (header));
+          r.stage_pos += sizeof (header);
+          r.msg_len = ntohl (header);
+          if (r.msg_len > opts.max_len)
+            {
+              r = msg_reader ();
+              error ("recv_msg: message of %lu bytes is longer than MAXLEN",
+                     (unsigned long) ntohl (header));
+              return octave_value ();
+            }
+          r.msg = recv_array ("uint8", dim_vector (1, r.msg_len));
+          r.msg_have = 0;
+          r.have_header = true;
+          break;
+        }
+
+      memmove (stage, stage + r.stage_pos, r.stage_end - r.stage_pos);
+      r.stage_end -= r.stage_pos;
+      r.stage_pos = 0;
+      n = recv_some (s, stage + r.stage_end, r.stage.size () - r.stage_end,
+                     opts.flags, opts.deadline);
+      if (n <= 0)
+        break;
+      r.stage_end += n;
+    }
+
+  // Read the data, straight into the message if there is a lot left
+  while (r.have_header)
+    {
+      const size_t take = std::min (r.stage_end - r.stage_pos,
+                                    r.msg_len - r.msg_have);
+      memcpy (r.msg.data () + r.msg_have, stage + r.stage_pos, take);
+      r.msg_have += take;
+      r.stage_pos += take;
+      if (r.msg_have == r.msg_len)
+        break;
+
+      r.stage_pos = r.stage_end = 0;
+      const size_t left = r.msg_len - r.msg_have;
+      if (left >= r.stage.size ())
+        {
+          n = recv_some (s, r.msg.data () + r.msg_have, left, opts.flags,
+                         opts.deadline);
+          if (n > 0)
+            r.msg_have += n;
+        }
+      else
+        {
+          n = recv_some (s, stage, r.stage.size (), opts.flags,
+                         opts.deadline);
+          if (n > 0)
+            r.stage_end = n;
+        }
+      if (n <= 0)
+        break;
+    }
+
+  octave_value_list return_list;
+  return_list(0) = recv_array (opts.cls, dim_vector (0, 0)).value ();
+  return_list(1) = -1;
+
+  if (n == -1)
+    {
+      error ("recv_msg failed with error %i (%s)", errno, strerror(errno));
+      r = msg_reader ();
+      return octave_value ();
+    }
+  else if (n == 0)
+    {
+      const bool partial = r.have_header || r.stage_end > r.stage_pos;
+      r = msg_reader ();
+      if (partial)
+        error ("recv_msg: connection closed in the middle of a message");
+      return return_list;
+    }
+  else if (n == -2)
+    return return_list;
+
+  // A complete message
+  recv_array data = r.msg;
+  const size_t len = r.msg_len;
+  r.msg = recv_array ();
+  r.have_header = false;
+
+  const size_t wordsize = class_word_size (opts.cls);
+  if (len % wordsize != 0)
+    {
+      error ("recv_msg: message length %ld is not a multiple of the %s element size",
+             long (len), opts.cls.c_str ());
+      return octave_value ();
+    }
+  if (opts.cls != "uint8")
+    {
+      recv_array typed (opts.cls, dim_vector (1, len / wordsize));
+      memcpy (typed.data (), data.data (), len);
+      data = typed;
+    }
+  if (opts.swap)
+    swap_bytes (data.data (), data.data (), len, wordsize);
+
+  return_list(0) = data.value ();
+  return_list(1) = len;
+  return return_list;
+}
+
+/*
+ * The binary matrix format of send_matrix and recv_matrix is a fixed
+ * header of 8 bytes: the magic "OMAT", the format version, the class
+ * code (the index in matrix_classes), the flags MATRIX_COMPLEX and
+ * MATRIX_BIG_ENDIAN, and the number of dimensions.  It is followed by
+ * the dimensions as 64 bit unsigned integers in network byte order and
+ * the column-major storage of the array in the byte order of the
+ * sender, which the receiver swaps if needed.
+ */
+static const char matrix_magic[] = "OMAT";
+static const unsigned char matrix_version = 1;
+static const char* const matrix_classes[] =
+{
+  "double", "single", "int8", "uint8", "int16", "uint16", "int32",
+  "uint32", "int64", "uint64", "char", "logical"
+};
+static const int n_matrix_classes = sizeof (matrix_classes) / sizeof (matrix_classes[0]);
+
+enum
+{
+  MATRIX_COMPLEX = 1,
+  MATRIX_BIG_ENDIAN = 2
+};
+
+/*
+ * helper function to build the header of the matrix format for the
+ * array A into HEADER, and to get its storage into BUF and NBYTES.
+ * Sets error_state if A can not be sent.
+ */
+static void encode_matrix (const octave_value& a,
+                           std::vector<unsigned char>& header,
+                           const char*& buf, size_t& nbytes, const char* who)
+{
+  const std::string cls = a.class_name ();
+  int code = 0;
+  while (code < n_matrix_classes && cls != matrix_classes[code])
+    code++;
+
+  size_t wordsize;
+  buf = get_raw_data (a, nbytes, wordsize);
+  if (code == n_matrix_classes || ! buf)
+    {
+      error ("%s: A must be a full numeric, logical or char array", who);
+      return;
+    }
+
+  const dim_vector dv = a.dims ();
+  const int ndims = dv.length ();
+  if (ndims > 255)
+    {
+      error ("%s: A has too many dimensions", who);
+      return;
+    }
+  header.resize (8 + 8 * ndims);
+  memcpy (&header[0], matrix_magic, 4);
+  header[4] = matrix_version;
+  header[5] = code;
+  header[6] = (a.is_complex_type () ? MATRIX_COMPLEX : 0)
+              | (host_is_big_endian () ? MATRIX_BIG_ENDIAN : 0);
+  header[7] = ndims;
+  for (int i = 0; i < ndims; i++)
+    {
+      uint64_t d = dv(i);
+      for (int j = 7; j >= 0; j--, d >>= 8)
+        header[8 + 8 * i + j] = d & 0xff;
+    }
+}
+
+/*
+ * helper function to check the fixed 8 bytes FIXED of a matrix header.
+ * Returns the number of dimensions that follow, or -1 if it is invalid.
+ */
+static int matrix_ndims (const unsigned char* fixed)
+{
+  if (memcmp (fixed, matrix_magic, 4) != 0 || fixed[4] != matrix_version
+      || fixed[5] >= n_matrix_classes || fixed[7] < 2
+      || ((fixed[6] & MATRIX_COMPLEX) && fixed[5] > 1))
+    return -1;
+  return fixed[7];
+}
+
+/*
+ * helper function to get dimension I of the matrix header dimensions
+ * DIMS.
+ */
+static inline uint64_t matrix_dim (const unsigned char* dims, int i)
+{
+  uint64_t d = 0;
+  for (int j = 0; j < 8; j++)
+    d = (d << 8) | dims[8 * i + j];
+  return d;
+}
+
+/*
+ * helper function returning the size in bytes of the storage of the
+ * array described by the matrix header FIXED and its dimensions DIMS.
+ * It is computed in double so that it can not overflow, and can be
+ * checked before anything is allocated.
+ */
+static double matrix_byte_size (const unsigned char* fixed,
+                                const unsigned char* dims)
+{
+  double nbytes = class_word_size (matrix_classes[fixed[5]])
+                  * ((fixed[6] & MATRIX_COMPLEX) ? 2 : 1);
+  for (int i = 0; i < fixed[7]; i++)
+    nbytes *= matrix_dim (dims, i);
+  return nbytes;
+}
+
+/*
+ * helper function to allocate the array described by the matrix header
+ * FIXED and its dimensions DIMS.  Sets error_state if the array is too
+ * large.
+ */
+static recv_array decode_matrix (const unsigned char* fixed,
+                                 const unsigned char* dims, const char* who)
+{
+  if (matrix_byte_size (fixed, dims)
+      > std::numeric_limits<octave_idx_type>::max ())
+    {
+      error ("%s: matrix is too large", who);
+      return recv_array ();
+    }
+
+  const int ndims = fixed[7];
+  dim_vector dv;
+  dv.resize (ndims);
+  for (int i = 0; i < ndims; i++)
+    dv(i) = matrix_dim (dims, i);
+
+  return recv_array (matrix_classes[fixed[5]], dv,
+                     fixed[6] & MATRIX_COMPLEX);
+}
+
+// PKG_ADD: autoload ("send_matrix", which ("socket"));
+// PKG_DEL: try; autoload ("send_matrix", which ("socket"), "remove"); catch; end;
+// function to send a matrix in binary form
+DEFUN_DLD(send_matrix, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {@var{count} =} send_matrix (@var{s}, @var{A})\n\
+@deftypefnx {Loadable Function} {@var{count} =} send_matrix (@var{s}, @var{A}, @var{flags})\n\
+@deftypefnx {Loadable Function} {@var{count} =} send_matrix (@dots{}, \"timeout\", @var{timeout})\n\
+Send a matrix on specified socket.\n\
+\n\
+Sends the array @var{A} on the stream socket @var{s} in a binary format\n\
+that @code{recv_matrix} turns back into an identical array.  @var{A} can\n\
+be a real or complex numeric array, or a logical or char array, of any\n\
+size.  The format carries the class, complexity, dimensions and byte\n\
+order of @var{A}, followed by its storage.  A small header and the\n\
+storage are sent together with scatter-gather I/O, without converting\n\
+or copying @var{A}.\n\
+\n\
+The @qcode{\"timeout\"} property is the same as for @code{sendall}.  The\n\
+number of bytes of storage sent is returned.\n\
+@seealso{recv_matrix, send_msg}\n\
+@end deftypefn")
+{
+  if (args.length () < 2)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  io_options opts;
+  get_io_options (args, 2, IO_OPT_TIMEOUT, opts, "send_matrix");
+  if (error_state)
+    return octave_value ();
+
+  // Determine the socket on which to operate
+  const int s = get_socket (args(0));
+  if (error_state)
+    {
+      error ("send_matrix: S must be a valid socket");
+      return octave_value ();
+    }
+
+  octave_value a = args(1);
+  if (a.is_range ())
+    a = a.array_value ();
+
+  std::vector<unsigned char> header;
+  const char* buf;
+  size_t nbytes;
+  encode_matrix (a, header, buf, nbytes, "send_matrix");
+  if (error_state)
+    return octave_value ();
+
+  struct iovec iov[2];
+  iov[0].iov_base = &header[0];
+  iov[0].iov_len = header.size ();
+  iov[1].iov_base = const_cast<char*> (buf);
+  iov[1].iov_len = nbytes;
+
+  const ssize_t retval = send_all_iov (s, iov, 2, opts.flags, opts.deadline);
+  if (retval == -1)
+    {
+      error ("send_matrix failed with error %i (%s)", errno, strerror(errno));
+      return octave_value ();
+    }
+  else if (size_t (retval) < header.size () + nbytes)
+    {
+      error ("send_matrix: timeout after sending %ld of %ld bytes",
+             long (retval), long (header.size () + nbytes));
+      return octave_value ();
+    }
+
+  return octave_value (nbytes);
+}
+
+// PKG_ADD: autoload ("recv_matrix", which ("socket"));
+// PKG_DEL: try; autoload ("recv_matrix", which ("socket"), "remove"); catch; end;
+// function to receive a matrix in binary form
+DEFUN_DLD(recv_matrix, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {[@var{A}, @var{count}] =} recv_matrix (@var{s})\n\
+@deftypefnx {Loadable Function} {[@var{A}, @var{count}] =} recv_matrix (@var{s}, @var{flags})\n\
+@deftypefnx {Loadable Function} {[@var{A}, @var{count}] =} recv_matrix (@dots{}, @var{property}, @var{value}, @dots{})\n\
+Read a matrix from specified socket.\n\
+\n\
+Reads an array sent with @code{send_matrix} from the stream socket\n\
+@var{s}.  The array is allocated once with the class and dimensions\n\
+given in the header, and its storage is received directly into it.  If\n\
+the sender has a different byte order, the elements are swapped in\n\
+place.  The number of bytes of storage received is returned in\n\
+@var{count}.\n\
+\n\
+If the peer shuts down the connection, or the @qcode{\"timeout\"} in\n\
+seconds expires, before the matrix starts to arrive, @var{A} is empty\n\
+and @var{count} is -1.  It is an error if this happens in the middle of\n\
+a matrix.\n\
+\n\
+Matrices whose storage is longer than the @qcode{\"maxlen\"} property,\n\
+64 MiB by default, are an error, since the dimensions come from the\n\
+peer.  The rest of the stream can then not be read as matrices.\n\
+\n\
+Do not mix @code{recv_matrix} and @code{recv_msg} on the same socket,\n\
+since @code{recv_msg} reads ahead.\n\
+@seealso{send_matrix, recv_msg}\n\
+@end deftypefn")
+{
+  if (args.length () < 1)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  io_options opts;
+  get_io_options (args, 1, IO_OPT_TIMEOUT | IO_OPT_MAX_LEN, opts,
+                  "recv_matrix");
+  if (error_state)
+    return octave_value ();
+
+  // Determine the socket on which to operate
+  const int s = get_socket (args(0));
+  if (error_state)
+    {
+      error ("recv_matrix: S must be a valid socket");
+      return octave_value ();
+    }
+
+  octave_value_list return_list;
+  return_list(0) = Matrix ();
+  return_list(1) = -1;
+
+  unsigned char fixed[8];
+  ssize_t n = transfer_all (s, reinterpret_cast<char*> (fixed), 8, false,
+                            opts.flags, opts.deadline);
+  if (n == 0)
+    return return_list;
+  else if (n == 8)
+    {
+      const int ndims = matrix_ndims (fixed);
+      if (ndims < 0)
+        {
+          error ("recv_matrix: invalid matrix header");
+          return octave_value ();
+        }
+
+      std::vector<unsigned char> dims (8 * ndims);
+      n = transfer_all (s, reinterpret_cast<char*> (&dims[0]), dims.size (),
+                        false, opts.flags, opts.deadline);
+      if (n == ssize_t (dims.size ()))
+        {
+          const double size = matrix_byte_size (fixed, &dims[0]);
+          if (size > opts.max_len)
+            {
+              error ("recv_matrix: matrix of %.0f bytes is longer than MAXLEN",
+                     size);
+              return octave_value ();
+            }
+
+          const recv_array a = decode_matrix (fixed, &dims[0], "recv_matrix");
+          if (error_state)
+            return octave_value ();
+          char* const buf = a.data ();
+          const size_t wordsize = class_word_size (matrix_classes[fixed[5]]);
+          const size_t nbytes = a.byte_size ();
+          n = transfer_all (s, buf, nbytes, false, opts.flags, opts.deadline);
+          if (n == ssize_t (nbytes))
+            {
+              if (bool (fixed[6] & MATRIX_BIG_ENDIAN) != host_is_big_endian ())
+                swap_bytes (buf, buf, nbytes, wordsize);
+
+              return_list(0) = a.value ();
+              return_list(1) = nbytes;
+              return return_list;
+            }
+        }
+    }
+
+  if (n == -1)
+    error ("recv_matrix failed with error %i (%s)", errno, strerror(errno));
+  else
+    error ("recv_matrix: connection closed or timeout in the middle of a matrix");
+  return octave_value ();
+}
+
+/*
+ * Shared memory channels.  A channel moves arrays from one process to
+ * another on the same host through a ring in a memfd that both map.
+ * The writer creates the memfd and passes it over an AF_UNIX socket with
+ * SCM_RIGHTS.  The socket then carries only control messages: for each
+ * array, the writer sends its position and length in the ring, and the
+ * reader answers with the position up to which it is done with the
+ * ring.  Positions count bytes since the start, the ring offset being
+ * the position modulo its size.  Each array is stored contiguously in
+ * the matrix format of send_matrix, starting at a multiple of 64 bytes.
+ */
+#if defined (__linux__) && defined (MFD_CLOEXEC)
+/*
+ * helper function to get the channel with the handle in ARG, setting
+ * error_state if there is none.
+ */
+static shm_channel* get_shm_channel (const octave_value& arg, const char* who)
+{
+  const int id = arg.int_value ();
+  std::map<int, shm_channel>::iterator it = shm_channels.find (id);
+  if (error_state || it == shm_channels.end ())
+    {
+      error ("%s: CH must be a channel of shm_channel_create or shm_channel_open",
+             who);
+      return 0;
+    }
+  return &it->second;
+}
+
+/*
+ * helper function to read the answers of the reader of channel C that
+ * are waiting on its socket, without blocking.  Returns false with
+ * errno set if the socket failed, or 0 if the reader closed it.
+ */
+static bool shm_read_acks (shm_channel& c)
+{
+  for (;;)
+    {
+      const ssize_t n = ::recv (c.sock, c.ack + c.ack_len, 8 - c.ack_len,
+                                MSG_DONTWAIT);
+      if (n == 0)
+        {
+          errno = 0;
+          return false;
+        }
+      else if (n == -1)
+        {
+          if (errno == EINTR)
+            continue;
+          return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+      c.ack_len += n;
+      if (c.ack_len == 8)
+        {
+          memcpy (&c.tail, c.ack, 8);
+          c.ack_len = 0;
+        }
+    }
+}
+
+// PKG_ADD: autoload ("shm_channel_create", which ("socket"));
+// PKG_DEL: try; autoload ("shm_channel_create", which ("socket"), "remove"); catch; end;
+// function to create the writing end of a shared memory channel
+DEFUN_DLD(shm_channel_create, args, , "\
+-*- texinfo -*-\n\
+@deftypefn {Loadable Function} {@var{ch} =} shm_channel_create (@var{s}, @var{ring_bytes})\n\
+Create a shared memory channel to send arrays to another process.\n\
+\n\
+Creates a ring of @var{ring_bytes} bytes in shared memory and passes it\n\
+over the connected AF_UNIX socket @var{s} to the process at the other\n\
+end, which opens the channel with @code{shm_channel_open}.  Arrays sent\n\
+with @code{shm_channel_send} are then written into the ring once and\n\
+copied out of it once by @code{shm_channel_recv}, instead of being\n\
+copied through the kernel; @var{s} only carries small control messages.\n\
+\n\
+The channel is one-way and uses @var{s} exclusively until it is closed\n\
+with @code{shm_channel_close}, or @var{s} is closed.  Each array, with a\n\
+header of 8 bytes plus 8 per dimension, must fit into the ring.  Linux\n\
+only.\n\
+@seealso{shm_channel_open, shm_channel_send, shm_channel_recv, shm_channel_close, socketpair}\n\
+@end deftypefn")
+{
+  if (args.length () != 2)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  const int s = get_socket (args(0));
+  if (error_state)
+    {
+      error ("shm_channel_create: S must be a valid socket");
+      return octave_value ();
+    }
+
+  const double size = args(1).double_value ();
+  if (error_state || size < 4096 || size != round (size)
+      || size > double (std::numeric_limits<off_t>::max ()))
+    {
+      error ("shm_channel_create: RING_BYTES must be an integer of at least 4096");
+      return octave_value ();
+    }
+
+  const int fd = memfd_create ("octave-shm-channel", MFD_CLOEXEC);
+  if (fd == -1)
+    {
+      error ("shm_channel_create: memfd_create failed with error %i (%s)",
+             errno, strerror(errno));
+      return octave_value ();
+    }
+
+  void* ring = MAP_FAILED;
+  if (ftruncate (fd, off_t (size)) == 0)
+    ring = mmap (0, size_t (size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (ring == MAP_FAILED)
+    {
+      const int err = errno;
+      ::close (fd);
+      error ("shm_channel_create: mapping the ring failed with error %i (%s)",
+             err, strerror(err));
+      return octave_value ();
+    }
+
+  // The size travels with the descriptor
+  uint64_t ring_size = size;
+  struct iovec iov;
+  iov.iov_base = &ring_size;
+  iov.iov_len = sizeof (ring_size);
+  char control[CMSG_SPACE (sizeof (int))];
+  memset (control, 0, sizeof (control));
+  struct msghdr msg;
+  memset (&msg, 0, sizeof (msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof (control);
+  struct cmsghdr* cm = CMSG_FIRSTHDR (&msg);
+  cm->cmsg_level = SOL_SOCKET;
+  cm->cmsg_type = SCM_RIGHTS;
+  cm->cmsg_len = CMSG_LEN (sizeof (int));
+  memcpy (CMSG_DATA (cm), &fd, sizeof (int));
+
+  ssize_t n;
+  do
+    n = sendmsg (s, &msg, 0);
+  while (n == -1 && errno == EINTR);
+  const int err = errno;
+  ::close (fd);
+  if (n != ssize_t (sizeof (ring_size)))
+    {
+      munmap (ring, size_t (size));
+      error ("shm_channel_create: passing the ring failed with error %i (%s)",
+             n == -1 ? err : EIO, strerror(n == -1 ? err : EIO));
+      return octave_value ();
+    }
+
+  shm_channel c;
+  c.sock = s;
+  c.writer = true;
+  c.ring = static_cast<char*> (ring);
+  c.size = size;
+  c.head = c.tail = 0;
+  c.ack_len = 0;
+  const int id = next_shm_channel++;
+  shm_channels[id] = c;
+  return octave_value (id);
+}
+
+// PKG_ADD: autoload ("shm_channel_open", which ("socket"));
+// PKG_DEL: try; autoload ("shm_channel_open", which ("socket"), "remove"); catch; end;
+// function to open the reading end of a shared memory channel
+DEFUN_DLD(shm_channel_open, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {@var{ch} =} shm_channel_open (@var{s})\n\
+@deftypefnx {Loadable Function} {@var{ch} =} shm_channel_open (@var{s}, \"timeout\", @var{timeout})\n\
+Open a shared memory channel to receive arrays from another process.\n\
+\n\
+Waits for the ring that the process at the other end of the AF_UNIX\n\
+socket @var{s} created with @code{shm_channel_create}, and maps it.\n\
+The @qcode{\"timeout\"} property is the maximum time in seconds to\n\
+wait, as for @code{sendall}.\n\
+@seealso{shm_channel_create, shm_channel_recv, shm_channel_close}\n\
+@end deftypefn")
+{
+  if (args.length () < 1)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  io_options opts;
+  get_io_options (args, 1, IO_OPT_TIMEOUT, opts, "shm_channel_open");
+  if (error_state)
+    return octave_value ();
+
+  const int s = get_socket (args(0));
+  if (error_state)
+    {
+      error ("shm_channel_open: S must be a valid socket");
+      return octave_value ();
+    }
+
+  uint64_t ring_size = 0;
+  struct iovec iov;
+  iov.iov_base = &ring_size;
+  iov.iov_len = sizeof (ring_size);
+  char control[CMSG_SPACE (sizeof (int))];
+  struct msghdr msg;
+  ssize_t n;
+  for (;;)
+    {
+      memset (&msg, 0, sizeof (msg));
+      msg.msg_iov = &iov;
+      msg.msg_iovlen = 1;
+      msg.msg_control = control;
+      msg.msg_controllen = sizeof (control);
+      n = recvmsg (s, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+      if (n != -1 || (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK))
+        break;
+      if (errno != EINTR)
+        {
+          const int rc = wait_socket (s, false, opts.deadline);
+          if (rc == 0)
+            errno = ETIMEDOUT;
+          if (rc <= 0)
+            break;
+        }
+    }
+
+  int fd = -1;
+  struct cmsghdr* cm = n > 0 ? CMSG_FIRSTHDR (&msg) : 0;
+  if (cm && cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_RIGHTS)
+    memcpy (&fd, CMSG_DATA (cm), sizeof (int));
+  if (n != ssize_t (sizeof (ring_size)) || fd == -1)
+    {
+      const int err = n == -1 ? errno : EPROTO;
+      if (fd != -1)
+        ::close (fd);
+      error ("shm_channel_open: receiving the ring failed with error %i (%s)",
+             err, strerror(err));
+      return octave_value ();
+    }
+
+  struct stat st;
+  void* ring = MAP_FAILED;
+  if (fstat (fd, &st) == 0 && uint64_t (st.st_size) == ring_size)
+    ring = mmap (0, ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  else
+    errno = EPROTO;
+  const int err = errno;
+  ::close (fd);
+  if (ring == MAP_FAILED)
+    {
+      error ("shm_channel_open: mapping the ring failed with error %i (%s)",
+             err, strerror(err));
+      return octave_value ();
+    }
+
+  shm_channel c;
+  c.sock = s;
+  c.writer = false;
+  c.ring = static_cast<char*> (ring);
+  c.size = ring_size;
+  c.head = c.tail = 0;
+  c.ack_len = 0;
+  const int id = next_shm_channel++;
+  shm_channels[id] = c;
+  return octave_value (id);
+}
+
+// PKG_ADD: autoload ("shm_channel_send", which ("socket"));
+// PKG_DEL: try; autoload ("shm_channel_send", which ("socket"), "remove"); catch; end;
+// function to send an array through a shared memory channel
+DEFUN_DLD(shm_channel_send, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {@var{count} =} shm_channel_send (@var{ch}, @var{A})\n\
+@deftypefnx {Loadable Function} {@var{count} =} shm_channel_send (@dots{}, \"timeout\", @var{timeout})\n\
+Send an array through a shared memory channel.\n\
+\n\
+Copies the array @var{A}, of any class accepted by @code{send_matrix},\n\
+into the ring of the channel @var{ch} created with\n\
+@code{shm_channel_create}, and tells the reader where it is.  If the\n\
+ring is too full, waits until the reader has taken enough arrays out,\n\
+at most the @qcode{\"timeout\"} in seconds, which is an error.  The\n\
+number of bytes of storage sent is returned.\n\
+@seealso{shm_channel_create, shm_channel_recv, send_matrix}\n\
+@end deftypefn")
+{
+  if (args.length () < 2)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  io_options opts;
+  get_io_options (args, 2, IO_OPT_TIMEOUT, opts, "shm_channel_send");
+  if (error_state)
+    return octave_value ();
+
+  shm_channel* c = get_shm_channel (args(0), "shm_channel_send");
+  if (error_state)
+    return octave_value ();
+  else if (! c->writer)
+    {
+      error ("shm_channel_send: CH is the reading end of the channel");
+      return octave_value ();
+    }
+
+  octave_value a = args(1);
+  if (a.is_range ())
+    a = a.array_value ();
+
+  std::vector<unsigned char> header;
+  const char* buf;
+  size_t nbytes;
+  encode_matrix (a, header, buf, nbytes, "shm_channel_send");
+  if (error_state)
+    return octave_value ();
+
+  const uint64_t len = header.size () + nbytes;
+  if (len > c->size)
+    {
+      error ("shm_channel_send: A needs %lu bytes but the ring has %lu",
+             (unsigned long) len, (unsigned long) c->size);
+      return octave_value ();
+    }
+
+  // Start on a cache line, and at the start of the ring if A does not
+  // fit before its end
+  uint64_t pos = (c->head + 63) & ~uint64_t (63);
+  if (pos % c->size + len > c->size)
+    pos += c->size - pos % c->size;
+
+  // The answers are taken on every send, not only when the ring is
+  // full, so that they never fill the socket buffer and block the reader
+  for (;;)
+    {
+      if (! shm_read_acks (*c))
+        {
+          const int err = errno ? errno : EPIPE;
+          error ("shm_channel_send: the reader failed with error %i (%s)",
+                 err, strerror(err));
+          return octave_value ();
+        }
+      if (pos + len - c->tail <= c->size)
+        break;
+      const int rc = wait_socket (c->sock, false, opts.deadline);
+      if (rc <= 0)
+        {
+          const int err = rc == 0 ? ETIMEDOUT : errno;
+          error ("shm_channel_send: waiting for room failed with error %i (%s)",
+                 err, strerror(err));
+          return octave_value ();
+        }
+    }
+
+  char* dst = c->ring + pos % c->size;
+  memcpy (dst, &header[0], header.size ());
+  memcpy (dst + header.size (), buf, nbytes);
+
+  uint64_t note[2] = {pos, len};
+  const ssize_t n = transfer_all (c->sock, reinterpret_cast<char*> (note),
+                                  sizeof (note), true, 0, opts.deadline);
+  if (n != ssize_t (sizeof (note)))
+    {
+      error ("shm_channel_send: signalling the reader failed with error %i (%s)",
+             n == -1 ? errno : ETIMEDOUT, strerror(n == -1 ? errno : ETIMEDOUT));
+      return octave_value ();
+    }
+  c->head = pos + len;
+  count_bytes (c->sock, nbytes, true);
+
+  return octave_value (nbytes);
+}
+
+// PKG_ADD: autoload ("shm_channel_recv", which ("socket"));
+// PKG_DEL: try; autoload ("shm_channel_recv", which ("socket"), "remove"); catch; end;
+// function to receive an array through a shared memory channel
+DEFUN_DLD(shm_channel_recv, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {[@var{A}, @var{count}] =} shm_channel_recv (@var{ch})\n\
+@deftypefnx {Loadable Function} {[@var{A}, @var{count}] =} shm_channel_recv (@dots{}, \"timeout\", @var{timeout})\n\
+Receive an array through a shared memory channel.\n\
+\n\
+Waits for the next array sent through the channel @var{ch} opened with\n\
+@code{shm_channel_open}, and returns it.  The array is allocated once\n\
+and filled from the ring with a single copy, after which its room in\n\
+the ring is given back to the writer.  The number of bytes of storage\n\
+received is returned in @var{count}.\n\
+\n\
+If the writer closes the socket, or the @qcode{\"timeout\"} in seconds\n\
+expires, before an array is announced, @var{A} is empty and @var{count}\n\
+is -1.\n\
+@seealso{shm_channel_open, shm_channel_send, recv_matrix}\n\
+@end deftypefn")
+{
+  if (args.length () < 1)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  io_options opts;
+  get_io_options (args, 1, IO_OPT_TIMEOUT, opts, "shm_channel_recv");
+  if (error_state)
+    return octave_value ();
+
+  shm_channel* c = get_shm_channel (args(0), "shm_channel_recv");
+  if (error_state)
+    return octave_value ();
+  else if (c->writer)
+    {
+      error ("shm_channel_recv: CH is the writing end of the channel");
+      return octave_value ();
+    }
+
+  octave_value_list return_list;
+  return_list(0) = Matrix ();
+  return_list(1) = -1;
+
+  uint64_t note[2];
+  const ssize_t n = transfer_all (c->sock, reinterpret_cast<char*> (note),
+                                  sizeof (note), false, 0, opts.deadline);
+  if (n == 0)
+    return return_list;
+  else if (n != ssize_t (sizeof (note)))
+    {
+      if (n == -1)
+        error ("shm_channel_recv failed with error %i (%s)", errno,
+               strerror(errno));
+      else
+        error ("shm_channel_recv: connection closed or timeout in the middle of a message");
+      return octave_value ();
+    }
+
+  const uint64_t pos = note[0];
+  const uint64_t len = note[1];
+  const unsigned char* src
+    = reinterpret_cast<const unsigned char*> (c->ring + pos % c->size);
+  const int ndims = (len >= 8 && len <= c->size - pos % c->size)
+    ? matrix_ndims (src) : -1;
+  // The message is at most the size of the ring, so checking the size
+  // of the array against it first bounds the allocation
+  if (ndims < 0 || len < 8 + 8 * uint64_t (ndims)
+      || matrix_byte_size (src, src + 8) != len - 8 - 8 * ndims)
+    {
+      error ("shm_channel_recv: invalid message in the ring");
+      return octave_value ();
+    }
+
+  const recv_array a = decode_matrix (src, src + 8, "shm_channel_recv");
+  if (error_state)
+    return octave_value ();
+  char* const buf = a.data ();
+  const size_t nbytes = a.byte_size ();
+  memcpy (buf, src + 8 + 8 * ndims, nbytes);
+  if (bool (src[6] & MATRIX_BIG_ENDIAN) != host_is_big_endian ())
+    swap_bytes (buf, buf, nbytes, class_word_size (matrix_classes[src[5]]));
+
+  // Give the room back
+  uint64_t done = pos + len;
+  if (transfer_all (c->sock, reinterpret_cast<char*> (&done), sizeof (done),
+                    true, 0, -1) != ssize_t (sizeof (done)))
+    {
+      error ("shm_channel_recv: answering the writer failed with error %i (%s)",
+             errno, strerror(errno));
+      return octave_value ();
+    }
+  count_bytes (c->sock, nbytes, false);
+
+  return_list(0) = a.value ();
+  return_list(1) = nbytes;
+  return return_list;
+}
+
+// PKG_ADD: autoload ("shm_channel_close", which ("socket"));
+// PKG_DEL: try; autoload ("shm_channel_close", which ("socket"), "remove"); catch; end;
+// function to close a shared memory channel
+DEFUN_DLD(shm_channel_close, args, , "\
+-*- texinfo -*-\n\
+@deftypefn {Loadable Function} {} shm_channel_close (@var{ch})\n\
+Close a shared memory channel.\n\
+\n\
+Unmaps the ring of the channel @var{ch} and forgets it.  The shared\n\
+memory is freed once both ends are closed.  The socket stays open.\n\
+@seealso{shm_channel_create, shm_channel_open}\n\
+@end deftypefn")
+{
+  if (args.length () != 1)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  shm_channel* c = get_shm_channel (args(0), "shm_channel_close");
+  if (error_state)
+    return octave_value ();
+
+  munmap (c->ring, c->size);
+  shm_channels.erase (args(0).int_value ());
+  return octave_value ();
+}
+#else
+DEFUNX_DLD ("shm_channel_create", Fshm_channel_create, Gshm_channel_create, args, nargout, "(not supported)")
+{ error( "shm_channel_create: not supported on this platform" );
+  return octave_value(); };
+DEFUNX_DLD ("shm_channel_open", Fshm_channel_open, Gshm_channel_open, args, nargout, "(not supported)")
+{ error( "shm_channel_open: not supported on this platform" );
+  return octave_value(); };
+DEFUNX_DLD ("shm_channel_send", Fshm_channel_send, Gshm_channel_send, args, nargout, "(not supported)")
+{ error( "shm_channel_send: not supported on this platform" );
+  return octave_value(); };
+DEFUNX_DLD ("shm_channel_recv", Fshm_channel_recv, Gshm_channel_recv, args, nargout, "(not supported)")
+{ error( "shm_channel_recv: not supported on this platform" );
+  return octave_value(); };
+DEFUNX_DLD ("shm_channel_close", Fshm_channel_close, Gshm_channel_close, args, nargout, "(not supported)")
+{ error( "shm_channel_close: not supported on this platform" );
+  return octave_value(); };
+#endif
+
+/*
+ * Streaming between files and sockets.  The data is moved by the kernel
+ * with sendfile and splice where possible, and through a bounded buffer
+ * otherwise, never through an octave array.
+ */
+#ifndef __WIN32__
+// bytes moved per system call, the default capacity of a Linux pipe
+static const size_t file_chunk = 65536;
+
+#ifdef __linux__
+/*
+ * helper function to send LEN bytes of the file FD from OFFSET over the
+ * non-blocking socket S with sendfile.  Returns as send_file_data, or -3
+ * with nothing sent if sendfile does not support the file.
+ */
+static ssize_t send_file_sendfile (int s, int fd, off_t& offset, size_t len,
+                                   double deadline)
+{
+  size_t done = 0;
+  while (done < len)
+    {
+      octave_quit ();
+
+      const size_t want = std::min (len - done, file_chunk);
+      const double t0 = io_clock ();
+      const ssize_t n = ::sendfile (s, fd, &offset, want);
+      count_io (s, IO_SEND, n, want, t0);
+      if (n > 0)
+        done += n;
+      else if (n == 0)
+        break;
+      else if (errno == EINTR)
+        continue;
+      else if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+          const int rc = wait_socket (s, true, deadline);
+          if (rc <= 0)
+            return rc == 0 ? ssize_t (done) : -1;
+        }
+      else if ((errno == EINVAL || errno == ENOSYS) && done == 0)
+        return -3;
+      else
+        return -1;
+    }
+  return done;
+}
+
+/*
+ * helper function to send LEN bytes of the file FD from OFFSET over the
+ * non-blocking socket S by splicing them through a pipe.  Returns as
+ * send_file_data, or -3 with nothing sent if splice does not support
+ * the file.
+ */
+static ssize_t send_file_splice (int s, int fd, off_t& offset, size_t len,
+                                 double deadline)
+{
+  int p[2];
+  if (pipe (p) == -1)
+    return -1;
+
+  size_t done = 0;
+  size_t in_pipe = 0;
+  ssize_t retval = 0;
+  while (done < len)
+    {
+      octave_quit ();
+
+      if (in_pipe == 0)
+        {
+          const ssize_t n = splice (fd, &offset, p[1], 0,
+                                    std::min (len - done, file_chunk),
+                                    SPLICE_F_MOVE);
+          if (n == 0)
+            break;
+          else if (n < 0 && errno == EINTR)
+            continue;
+          else if (n < 0)
+            {
+              retval = ((errno == EINVAL || errno == ENOSYS) && done == 0)
+                       ? -3 : -1;
+              break;
+            }
+          in_pipe = n;
+        }
+
+      const double t0 = io_clock ();
+      const ssize_t n = splice (p[0], 0, s, 0, in_pipe,
+                                SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+      count_io (s, IO_SEND, n, in_pipe, t0);
+      if (n > 0)
+        {
+          in_pipe -= n;
+          done += n;
+        }
+      else if (n < 0 && errno == EINTR)
+        continue;
+      else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+          const int rc = wait_socket (s, true, deadline);
+          if (rc <= 0)
+            {
+              retval = rc;
+              break;
+            }
+        }
+      else
+        {
+          retval = -1;
+          break;
+        }
+    }
+
+  const int err = errno;
+  close (p[0]);
+  close (p[1]);
+  errno = err;
+  return retval < 0 ? retval : ssize_t (done);
+}
+#endif
+
+/*
+ * helper function to send LEN bytes of the file FD from OFFSET over the
+ * non-blocking socket S, waiting for it until DEADLINE.  Uses sendfile,
+ * splice through a pipe if sendfile does not support the file, and
+ * pread otherwise.  Returns the number of bytes sent, short only on end
+ * of file or timeout, or -1 on error with errno set.
+ */
+static ssize_t send_file_data (int s, int fd, off_t offset, size_t len,
+                               double deadline)
+{
+#ifdef __linux__
+  ssize_t n = send_file_sendfile (s, fd, offset, len, deadline);
+  if (n == -3)
+    n = send_file_splice (s, fd, offset, len, deadline);
+  if (n != -3)
+    return n;
+#endif
+
+  std::vector<char> buf (std::min (len, file_chunk));
+  size_t done = 0;
+  while (done < len)
+    {
+      const ssize_t n = pread (fd, &buf[0], std::min (len - done, buf.size ()),
+                               offset);
+      if (n == 0)
+        break;
+      else if (n < 0 && errno == EINTR)
+        continue;
+      else if (n < 0)
+        return -1;
+      offset += n;
+
+      const ssize_t k = transfer_all (s, &buf[0], n, true, 0, deadline);
+      if (k < 0)
+        return -1;
+      done += k;
+      if (k < n)
+        break;
+    }
+  return done;
+}
+
+/*
+ * helper function to write LEN bytes of BUF to the file FD.  Returns 0
+ * on success and -1 on error with errno set.
+ */
+static int write_all (int fd, const char* buf, size_t len)
+{
+  while (len > 0)
+    {
+      const ssize_t n = write (fd, buf, len);
+      if (n < 0 && errno == EINTR)
+        continue;
+      else if (n < 0)
+        return -1;
+      buf += n;
+      len -= n;
+    }
+  return 0;
+}
+
+/*
+ * helper function to receive up to LEN bytes from the non-blocking
+ * socket S into the file FD, waiting for data until DEADLINE.  On Linux
+ * the data is spliced through a pipe.  Returns the number of bytes
+ * written, short only if the peer shut down or on timeout, or -1 on
+ * error with errno set.
+ */
+static ssize_t recv_file_data (int s, int fd, size_t len, double deadline)
+{
+  size_t done = 0;
+
+#ifdef __linux__
+  int p[2];
+  if (pipe (p) == -1)
+    return -1;
+
+  bool use_splice = true;
+  ssize_t retval = 0;
+  while (done < len)
+    {
+      octave_quit ();
+
+      const size_t want = std::min (len - done, file_chunk);
+      const double t0 = io_clock ();
+      ssize_t n = splice (s, 0, p[1], 0, want,
+                          SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+      count_io (s, IO_RECV, n, want, t0);
+      if (n == 0)
+        break;
+      else if (n < 0 && errno == EINTR)
+        continue;
+      else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+          const int rc = wait_socket (s, false, deadline);
+          if (rc <= 0)
+            {
+              retval = rc;
+              break;
+            }
+          continue;
+        }
+      else if (n < 0 && errno == EINVAL && done == 0)
+        {
+          use_splice = false;
+          break;
+        }
+      else if (n < 0)
+        {
+          retval = -1;
+          break;
+        }
+
+      // Move what was received to the file
+      while (n > 0)
+        {
+          const ssize_t k = splice (p[0], 0, fd, 0, n, SPLICE_F_MOVE);
+          if (k < 0 && errno == EINTR)
+            continue;
+          else if (k <= 0)
+            {
+              retval = -1;
+              break;
+            }
+          n -= k;
+          done += k;
+        }
+      if (retval == -1)
+        break;
+    }
+
+  const int err = errno;
+  close (p[0]);
+  close (p[1]);
+  errno = err;
+  if (use_splice)
+    return retval == -1 ? -1 : ssize_t (done);
+#endif
+
+  std::vector<char> buf (std::min (len, file_chunk));
+  while (done < len)
+    {
+      const ssize_t n = recv_some (s, &buf[0],
+                                   std::min (len - done, buf.size ()), 0,
+                                   deadline);
+      if (n == -2 || n == 0)
+        break;
+      else if (n < 0 || write_all (fd, &buf[0], n) == -1)
+        return -1;
+      done += n;
+    }
+  return done;
+}
+
+// PKG_ADD: autoload ("sendfile", which ("socket"));
+// PKG_DEL: try; autoload ("sendfile", which ("socket"), "remove"); catch; end;
+// function to send a file over a socket
+DEFUN_DLD(sendfile, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {@var{count} =} sendfile (@var{s}, @var{filename})\n\
+@deftypefnx {Loadable Function} {@var{count} =} sendfile (@var{s}, @var{filename}, @var{offset})\n\
+@deftypefnx {Loadable Function} {@var{count} =} sendfile (@var{s}, @var{filename}, @var{offset}, @var{len})\n\
+@deftypefnx {Loadable Function} {@var{count} =} sendfile (@dots{}, \"timeout\", @var{timeout})\n\
+Send a file over a socket.\n\
+\n\
+Sends @var{len} bytes of the file @var{filename}, starting at byte\n\
+@var{offset}, over the socket @var{s}.  By default the whole file is\n\
+sent.  On Linux the data goes from the file to the socket inside the\n\
+kernel, with @command{sendfile} or @command{splice}, without being\n\
+copied to octave.\n\
+\n\
+Like @code{sendall}, partial transfers are retried until everything is\n\
+sent, Ctrl-C is honoured, and the @qcode{\"timeout\"} property sets the\n\
+maximum time in seconds to wait.  Returns the number of bytes sent,\n\
+which is less than @var{len} only if the timeout expired or the file is\n\
+shorter.\n\
+@seealso{recv_to_file, sendall}\n\
+@end deftypefn")
+{
+  const octave_idx_type nargin = args.length ();
+  if (nargin < 2)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  const int s = get_socket (args(0));
+  if (error_state)
+    {
+      error ("sendfile: S must be a valid socket");
+      return octave_value ();
+    }
+
+  const std::string filename = args(1).string_value ();
+  if (error_state)
+    {
+      error ("sendfile: FILENAME must be a string");
+      return octave_value ();
+    }
+
+  octave_idx_type first_opt = 2;
+  double offset = 0;
+  double len = -1;
+  if (nargin > 2 && ! args(2).is_string ())
+    {
+      offset = args(2).double_value ();
+      first_opt++;
+      if (nargin > 3 && ! args(3).is_string ())
+        {
+          len = args(3).double_value ();
+          first_opt++;
+        }
+      if (error_state || offset < 0 || offset != floor (offset))
+        {
+          error ("sendfile: OFFSET and LEN must be non-negative integers");
+          return octave_value ();
+        }
+    }
+
+  io_options opts;
+  get_io_options (args, first_opt, IO_OPT_TIMEOUT, opts, "sendfile");
+  if (error_state)
+    return octave_value ();
+
+  const int fd = open (filename.c_str (), O_RDONLY);
+  if (fd == -1)
+    {
+      error ("sendfile: could not open %s (%s)", filename.c_str (),
+             strerror(errno));
+      return octave_value ();
+    }
+
+  // Without LEN, send up to the end of the file
+  struct stat st;
+  if (len < 0 && fstat (fd, &st) == 0 && S_ISREG (st.st_mode))
+    len = std::max (double (st.st_size) - offset, 0.0);
+  const size_t nbytes = len < 0 ? std::numeric_limits<size_t>::max ()
+                                : size_t (len);
+
+  ssize_t retval = -1;
+  const int was_nonblocking = set_nonblocking (s, true);
+  if (was_nonblocking != -1)
+    {
+      retval = send_file_data (s, fd, off_t (offset), nbytes, opts.deadline);
+      const int err = errno;
+      if (! was_nonblocking)
+        set_nonblocking (s, false);
+      errno = err;
+    }
+  const int err = errno;
+  close (fd);
+  if (retval == -1)
+    {
+      error ("sendfile failed with error %i (%s)", err, strerror(err));
+      return octave_value ();
+    }
+
+  return octave_value (double (retval));
+}
+
+// PKG_ADD: autoload ("recv_to_file", which ("socket"));
+// PKG_DEL: try; autoload ("recv_to_file", which ("socket"), "remove"); catch; end;
+// function to receive from a socket into a file
+DEFUN_DLD(recv_to_file, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {@var{count} =} recv_to_file (@var{s}, @var{filename})\n\
+@deftypefnx {Loadable Function} {@var{count} =} recv_to_file (@var{s}, @var{filename}, @var{len})\n\
+@deftypefnx {Loadable Function} {@var{count} =} recv_to_file (@dots{}, \"timeout\", @var{timeout})\n\
+Receive data from a socket into a file.\n\
+\n\
+Receives @var{len} bytes from the socket @var{s} and writes them to the\n\
+file @var{filename}, which is created or truncated.  By default, or if\n\
+@var{len} is Inf, data is received until the peer shuts down the\n\
+connection.  On Linux the data goes from the socket to the file inside\n\
+the kernel, spliced through a pipe, without being copied to octave.\n\
+\n\
+Ctrl-C is honoured, and the @qcode{\"timeout\"} property sets the\n\
+maximum time in seconds to wait, as for @code{recvall}.  Returns the\n\
+number of bytes written.\n\
+@seealso{sendfile, recvall}\n\
+@end deftypefn")
+{
+  const octave_idx_type nargin = args.length ();
+  if (nargin < 2)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  const int s = get_socket (args(0));
+  if (error_state)
+    {
+      error ("recv_to_file: S must be a valid socket");
+      return octave_value ();
+    }
+
+  const std::string filename = args(1).string_value ();
+  if (error_state)
+    {
+      error ("recv_to_file: FILENAME must be a string");
+      return octave_value ();
+    }
+
+  octave_idx_type first_opt = 2;
+  size_t len = std::numeric_limits<size_t>::max ();
+  if (nargin > 2 && ! args(2).is_string ())
+    {
+      const double l = args(2).double_value ();
+      if (error_state || l < 0)
+        {
+          error ("recv_to_file: LEN must be a non-negative integer");
+          return octave_value ();
+        }
+      if (l < double (std::numeric_limits<size_t>::max ()))
+        len = size_t (l);
+      first_opt++;
+    }
+
+  io_options opts;
+  get_io_options (args, first_opt, IO_OPT_TIMEOUT, opts, "recv_to_file");
+  if (error_state)
+    return octave_value ();
+
+  const int fd = open (filename.c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (fd == -1)
+    {
+      error ("recv_to_file: could not open %s (%s)", filename.c_str (),
+             strerror(errno));
+      return octave_value ();
+    }
+
+  ssize_t retval = -1;
+  const int was_nonblocking = set_nonblocking (s, true);
+  if (was_nonblocking != -1)
+    {
+      retval = recv_file_data (s, fd, len, opts.deadline);
+      const int err = errno;
+      if (! was_nonblocking)
+        set_nonblocking (s, false);
+      errno = err;
+    }
+  int err = errno;
+  if (close (fd) == -1 && retval != -1)
+    {
+      err = errno;
+      retval = -1;
+    }
+  if (retval == -1)
+    {
+      error ("recv_to_file failed with error %i (%s)", err, strerror(err));
+      return octave_value ();
+    }
+
+  return octave_value (double (retval));
+}
+/*
+ * helper function to parse a madvise ADVICE name.  Returns -1 and sets
+ * error_state if it is unknown.
+ */
+static int get_madvise_advice (const octave_value& arg, const char* who)
+{
+  const std::string advice = arg.string_value ();
+  if (! error_state)
+    {
+      if (advice == "normal")
+        return MADV_NORMAL;
+      else if (advice == "sequential")
+        return MADV_SEQUENTIAL;
+      else if (advice == "willneed")
+        return MADV_WILLNEED;
+#ifdef MADV_HUGEPAGE
+      else if (advice == "hugepage")
+        return MADV_HUGEPAGE;
+#endif
+    }
+  error ("%s: unknown ADVICE", who);
+  return -1;
+}
+
+// bytes of the file mapped at a time, a multiple of any page size
+static const size_t mmap_window = size_t (256) << 20;
+
+// PKG_ADD: autoload ("recv_mmap", which ("socket"));
+// PKG_DEL: try; autoload ("recv_mmap", which ("socket"), "remove"); catch; end;
+// function to receive into a memory-mapped file
+DEFUN_DLD(recv_mmap, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {[@var{count}, @var{nread}] =} recv_mmap (@var{s}, @var{filename}, @var{nbytes})\n\
+@deftypefnx {Loadable Function} {[@var{count}, @var{nread}] =} recv_mmap (@var{s}, @var{filename}, @var{nbytes}, @var{class})\n\
+@deftypefnx {Loadable Function} {[@var{count}, @var{nread}] =} recv_mmap (@var{s}, @var{filename}, @var{nbytes}, @var{class}, @var{dims})\n\
+@deftypefnx {Loadable Function} {[@var{count}, @var{nread}] =} recv_mmap (@dots{}, @var{property}, @var{value}, @dots{})\n\
+Receive data from a socket into a memory-mapped file.\n\
+\n\
+Creates the file @var{filename} with a size of @var{nbytes} bytes, maps\n\
+it into memory and receives from the socket @var{s} straight into the\n\
+mapping, without any intermediate buffer.  The file is mapped\n\
+256 MiB at a time, so that it can be larger than memory; the kernel\n\
+writes the received pages back to disk in the background.\n\
+\n\
+@var{class} is the class of the elements, \"uint8\" by default, and\n\
+@var{dims} their dimensions, whose product times the size of an element\n\
+must then be @var{nbytes}.  They are only used to check @var{nbytes},\n\
+to convert the byte order and to count elements: the file holds the raw\n\
+data, which can be read back with @code{fread} or mapped by other\n\
+tools.\n\
+\n\
+The properties are:\n\
+\n\
+@table @code\n\
+@item byteorder\n\
+the byte order of the data sent, as for @code{recv}.  The elements are\n\
+converted to the native byte order in the file.\n\
+\n\
+@item timeout\n\
+the maximum time to wait in seconds, as for @code{recvall}\n\
+\n\
+@item advice\n\
+a hint to the kernel about the use of the mapping: \"normal\",\n\
+\"sequential\" (the default), \"willneed\" or, on Linux, \"hugepage\".\n\
+@end table\n\
+\n\
+Returns the number @var{count} of complete elements and the number\n\
+@var{nread} of bytes received.  If the peer shut down or the timeout\n\
+expired before @var{nbytes} arrived, the file is truncated to\n\
+@var{nread} bytes.  On Linux the disk space is allocated up front, so\n\
+that a full disk is reported before anything is received.  If receiving\n\
+fails, the file is truncated to the bytes that arrived before the\n\
+error is raised.\n\
+@seealso{recv_to_file, recvall}\n\
+@end deftypefn")
+{
+  const octave_idx_type nargin = args.length ();
+  if (nargin < 3)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  const int s = get_socket (args(0));
+  if (error_state)
+    {
+      error ("recv_mmap: S must be a valid socket");
+      return octave_value ();
+    }
+
+  const std::string filename = args(1).string_value ();
+  if (error_state)
+    {
+      error ("recv_mmap: FILENAME must be a string");
+      return octave_value ();
+    }
+
+  const double nbytes_arg = args(2).double_value ();
+  if (error_state || nbytes_arg < 0 || nbytes_arg != floor (nbytes_arg))
+    {
+      error ("recv_mmap: NBYTES must be a non-negative integer");
+      return octave_value ();
+    }
+  const size_t nbytes = size_t (nbytes_arg);
+
+  // The class is the only string that is not a property name
+  octave_idx_type i = 3;
+  std::string cls = "uint8";
+  if (nargin > i && args(i).is_string ()
+      && args(i).string_value () != "byteorder"
+      && args(i).string_value () != "timeout"
+      && args(i).string_value () != "advice")
+    {
+      cls = args(i++).string_value ();
+      if (class_word_size (cls) == 0)
+        {
+          error ("recv_mmap: unsupported CLASS");
+          return octave_value ();
+        }
+    }
+  const size_t wordsize = class_word_size (cls);
+  if (nargin > i && ! args(i).is_string ())
+    {
+      const dim_vector dv = get_dims (args(i++), "recv_mmap");
+      if (error_state)
+        return octave_value ();
+      if (double (dv.numel ()) * wordsize != nbytes_arg)
+        {
+          error ("recv_mmap: DIMS do not match NBYTES");
+          return octave_value ();
+        }
+    }
+
+  // advice is handled here, the other properties as for recvall
+  int advice = MADV_SEQUENTIAL;
+  octave_value_list props;
+  for (; i + 1 < nargin; i += 2)
+    {
+      if (args(i).is_string () && args(i).string_value () == "advice")
+        advice = get_madvise_advice (args(i+1), "recv_mmap");
+      else
+        {
+          props.append (args(i));
+          props.append (args(i+1));
+        }
+      if (error_state)
+        return octave_value ();
+    }
+  if (i < nargin)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+  io_options opts;
+  get_io_options (props, 0, IO_OPT_BYTEORDER | IO_OPT_TIMEOUT, opts,
+                  "recv_mmap");
+  if (error_state)
+    return octave_value ();
+
+  const int fd = open (filename.c_str (), O_RDWR | O_CREAT | O_TRUNC, 0666);
+  if (fd == -1)
+    {
+      error ("recv_mmap: could not open %s (%s)", filename.c_str (),
+             strerror(errno));
+      return octave_value ();
+    }
+  if (ftruncate (fd, nbytes) == -1)
+    {
+      error ("recv_mmap: could not size %s (%s)", filename.c_str (),
+             strerror(errno));
+      close (fd);
+      return octave_value ();
+    }
+#ifdef __linux__
+  // Writing to a hole of a full disk through the mapping raises SIGBUS
+  const int rc = nbytes > 0 ? posix_fallocate (fd, 0, nbytes) : 0;
+  if (rc != 0 && rc != EOPNOTSUPP && rc != EINVAL)
+    {
+      error ("recv_mmap: could not allocate %s (%s)", filename.c_str (),
+             strerror(rc));
+      close (fd);
+      return octave_value ();
+    }
+#endif
+
+  // Receive one window of the file at a time
+  size_t done = 0;
+  int err = 0;
+  while (done < nbytes)
+    {
+      const size_t len = std::min (nbytes - done, mmap_window);
+      void* map = mmap (0, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, done);
+      if (map == MAP_FAILED)
+        {
+          err = errno;
+          break;
+        }
+      madvise (map, len, advice);
+
+      char* buf = static_cast<char*> (map);
+      size_t got = 0;
+      const ssize_t n = transfer_all (s, buf, len, false, opts.flags,
+                                      opts.deadline, &got);
+      if (n < 0)
+        err = errno;
+      if (opts.swap)
+        swap_bytes (buf, buf, got - got % wordsize, wordsize);
+
+      // Start writing back while the next window is received
+      if (got > 0)
+        msync (map, got, MS_ASYNC);
+      munmap (map, len);
+
+      done += got;
+      if (n < 0 || got < len)
+        break;
+    }
+
+  // Keep only what arrived, also if receiving failed
+  if (done < nbytes && ftruncate (fd, done) == -1 && ! err)
+    err = errno;
+  if (close (fd) == -1 && ! err)
+    err = errno;
+  if (err)
+    {
+      error ("recv_mmap failed with error %i (%s)", err, strerror(err));
+      return octave_value ();
+    }
+
+  octave_value_list return_list;
+  return_list(0) = double (done / wordsize);
+  return_list(1) = double (done);
+  return return_list;
+}
+
+#else
+DEFUNX_DLD ("sendfile", Fsendfile, Gsendfile, args, nargout, "(not supported)")
+{ error( "sendfile: not supported on this platform" );
+  return octave_value(); };
+DEFUNX_DLD ("recv_to_file", Frecv_to_file, Grecv_to_file, args, nargout, "(not supported)")
+{ error( "recv_to_file: not supported on this platform" );
+  return octave_value(); };
+DEFUNX_DLD ("recv_mmap", Frecv_mmap, Grecv_mmap, args, nargout, "(not supported)")
+{ error( "recv_mmap: not supported on this platform" );
+  return octave_value(); };
+#endif
+
+// PKG_ADD: autoload ("recv_async_start", which ("socket"));
+// PKG_DEL: try; autoload ("recv_async_start", which ("socket"), "remove"); catch; end;
+// function to start receiving in the background
+#ifndef __WIN32__
+DEFUN_DLD(recv_async_start, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {} recv_async_start (@var{s})\n\
+@deftypefnx {Loadable Function} {} recv_async_start (@var{s}, @var{ring_bytes})\n\
+Start receiving from specified socket in the background.\n\
+\n\
+Starts a thread that keeps reading from the socket @var{s} into a ring\n\
+buffer of @var{ring_bytes} bytes (1 MiB by default, rounded up to a\n\
+power of two), while octave is busy with other work.  This keeps the\n\
+socket buffer of the kernel drained, so that a TCP sender is not\n\
+stalled.  When the ring buffer is full, the thread waits for it to be\n\
+read.\n\
+\n\
+The data is read from the ring buffer with @code{recv_async_read},\n\
+without a system call.  Do not call other receiving functions on\n\
+@var{s} until @code{recv_async_stop}.  The thread also stops at the end\n\
+of the stream, on error, and when @var{s} is closed with\n\
+@code{disconnect}.\n\
+@seealso{recv_async_read, recv_async_stats, recv_async_stop}\n\
+@end deftypefn")
+{
+  const octave_idx_type nargin = args.length ();
+
+  if (nargin < 1 || nargin > 2)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  // Determine the socket on which to operate
+  const int s = get_socket (args(0));
+  if (error_state)
+    {
+      error ("recv_async_start: S must be a valid socket");
+      return octave_value ();
+    }
+
+  double ring_bytes = 1 << 20;
+  if (nargin > 1)
+    {
+      ring_bytes = args(1).double_value ();
+      if (error_state || ring_bytes < 1 || ring_bytes > 1e15)
+        {
+          error ("recv_async_start: RING_BYTES must be a positive integer");
+          return octave_value ();
+        }
+    }
+  size_t size = 1;
+  while (size < ring_bytes)
+    size <<= 1;
+
+  if (async_readers.count (s))
+    {
+      error ("recv_async_start: socket %i is already read in the background", s);
+      return octave_value ();
+    }
+
+  // The thread never blocks writing to READY
+  async_reader* r = new async_reader (s, size);
+  if (::pipe (r->wake) == -1 || ::pipe (r->ready) == -1
+      || fcntl (r->ready[0], F_SETFL, O_NONBLOCK) == -1
+      || fcntl (r->ready[1], F_SETFL, O_NONBLOCK) == -1)
+    {
+      error ("recv_async_start failed with error %i (%s)", errno, strerror(errno));
+      for (int i = 0; i < 2; i++)
+        {
+          if (r->wake[i] != -1)
+            ::close (r->wake[i]);
+          if (r->ready[i] != -1)
+            ::close (r->ready[i]);
+        }
+      delete r;
+      return octave_value ();
+    }
+  r->thread = std::thread (async_reader_loop, r);
+  async_readers[s] = r;
+
+  // The thread runs code of this file, so it must stay loaded
+  static bool locked = false;
+  if (! locked)
+    {
+      mlock ();
+      locked = true;
+    }
+
+  return octave_value ();
+}
+
+// PKG_ADD: autoload ("recv_async_read", which ("socket"));
+// PKG_DEL: try; autoload ("recv_async_read", which ("socket"), "remove"); catch; end;
+// function to read data received in the background
+DEFUN_DLD(recv_async_read, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {[@var{data}, @var{count}] =} recv_async_read (@var{s}, @var{len})\n\
+@deftypefnx {Loadable Function} {[@var{data}, @var{count}] =} recv_async_read (@dots{}, @var{property}, @var{value}, @dots{})\n\
+Read data received in the background.\n\
+\n\
+Takes at most @var{len} bytes that the thread started with\n\
+@code{recv_async_start} has received from socket @var{s}, and returns\n\
+them as a row vector in @var{data} and their number in @var{count}.\n\
+Taking available data does not make a system call.  By default it\n\
+returns immediately with whatever data is available.  With the\n\
+@qcode{\"timeout\"} property it sleeps up to that many seconds until the\n\
+thread has received @var{len} bytes.\n\
+\n\
+Once the stream has ended and all data has been read, @var{count} is\n\
+-1.  The @qcode{\"class\"} and @qcode{\"byteorder\"} properties are the\n\
+same as for @code{recv}, and only complete elements are taken.\n\
+@seealso{recv_async_start, recv_async_stats, recv_async_stop}\n\
+@end deftypefn")
+{
+  if (args.length () < 2)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  io_options opts;
+  get_io_options (args, 2, IO_OPT_BYTEORDER | IO_OPT_CLASS | IO_OPT_TIMEOUT,
+                  opts, "recv_async_read");
+  if (error_state)
+    return octave_value ();
+
+  // Determine the socket on which to operate
+  const int s = get_socket (args(0));
+  if (error_state)
+    {
+      error ("recv_async_read: S must be a valid socket");
+      return octave_value ();
+    }
+
+  const octave_idx_type len = args(1).idx_type_value ();
+  if (error_state || len < 0)
+    {
+      error ("recv_async_read: LEN must be a non-negative integer");
+      return octave_value ();
+    }
+
+  std::map<int, async_reader*>::iterator it = async_readers.find (s);
+  if (it == async_readers.end ())
+    {
+      error ("recv_async_read: socket %i is not read in the background", s);
+      return octave_value ();
+    }
+  async_reader* r = it->second;
+
+  // Sleep until the thread signals data, checking again once it knows
+  // to signal
+  const uint64_t tail = r->tail.load (std::memory_order_relaxed);
+  uint64_t head = r->head.load (std::memory_order_acquire);
+  while (head - tail < uint64_t (len) && opts.deadline >= 0 && ! r->done)
+    {
+      const int slice_ms = wait_slice_ms (opts.deadline);
+      if (slice_ms == 0)
+        break;
+      r->want_data = true;
+      head = r->head.load ();
+      if (head - tail >= uint64_t (len) || r->done)
+        break;
+
+      struct pollfd pfd;
+      pfd.fd = r->ready[0];
+      pfd.events = POLLIN;
+      pfd.revents = 0;
+      if (::poll (&pfd, 1, slice_ms) > 0)
+        {
+          char c[64];
+          while (::read (r->ready[0], c, sizeof (c)) > 0)
+            ;
+        }
+      head = r->head.load (std::memory_order_acquire);
+    }
+  r->want_data = false;
+
+  // Data received before the thread stopped is visible once it has
+  const bool finished = r->done;
+  head = r->head.load (std::memory_order_acquire);
+
+  const size_t wordsize = class_word_size (opts.cls);
+  const size_t avail = head - tail;
+  const size_t nbytes = (std::min (avail, size_t (len)) / wordsize) * wordsize;
+
+  octave_value_list return_list;
+  recv_array data (opts.cls, dim_vector (1, nbytes / wordsize));
+  char* const buf = data.data ();
+  if (nbytes == 0 && avail == 0 && finished)
+    {
+      return_list(0) = data.value ();
+      return_list(1) = -1;
+      return return_list;
+    }
+
+  // Copy out of the ring, which may wrap around
+  const size_t pos = tail & r->mask;
+  const size_t first = std::min (nbytes, r->ring.size () - pos);
+  memcpy (buf, &r->ring[pos], first);
+  memcpy (buf + first, &r->ring[0], nbytes - first);
+  r->tail.store (tail + nbytes);
+  if (nbytes > 0 && r->want_room.exchange (false))
+    async_notify (r->wake[1], 1);
+
+  if (opts.swap)
+    swap_bytes (buf, buf, nbytes, wordsize);
+
+  return_list(0) = data.value ();
+  return_list(1) = nbytes;
+  return return_list;
+}
+
+// PKG_ADD: autoload ("recv_async_stats", which ("socket"));
+// PKG_DEL: try; autoload ("recv_async_stats", which ("socket"), "remove"); catch; end;
+// function to get the state of background receiving
+DEFUN_DLD(recv_async_stats, args, , "\
+-*- texinfo -*-\n\
+@deftypefn {Loadable Function} {@var{stats} =} recv_async_stats (@var{s})\n\
+Return the state of receiving from specified socket in the background.\n\
+\n\
+Returns a struct with the following fields:\n\
+\n\
+@table @code\n\
+@item ring_bytes\n\
+the size of the ring buffer\n\
+\n\
+@item buffered\n\
+the number of bytes received and not yet read\n\
+\n\
+@item bytes_received\n\
+the total number of bytes received by the thread\n\
+\n\
+@item recv_calls\n\
+the number of @code{recv} system calls made by the thread\n\
+\n\
+@item ring_full\n\
+the number of times the thread found the ring buffer full\n\
+\n\
+@item running\n\
+true until the thread stops at the end of the stream or on error\n\
+\n\
+@item error\n\
+the error number that stopped the thread, or 0\n\
+@end table\n\
+@seealso{recv_async_start, recv_async_read, recv_async_stop}\n\
+@end deftypefn")
+{
+  if (args.length () != 1)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  // Determine the socket on which to operate
+  const int s = get_socket (args(0));
+  if (error_state)
+    {
+      error ("recv_async_stats: S must be a valid socket");
+      return octave_value ();
+    }
+
+  std::map<int, async_reader*>::iterator it = async_readers.find (s);
+  if (it == async_readers.end ())
+    {
+      error ("recv_async_stats: socket %i is not read in the background", s);
+      return octave_value ();
+    }
+  const async_reader* r = it->second;
+
+  octave_scalar_map stats;
+  stats.assign ("ring_bytes", octave_value (double (r->ring.size ())));
+  stats.assign ("buffered", octave_value (double (r->head - r->tail)));
+  stats.assign ("bytes_received", octave_value (double (r->bytes_received)));
+  stats.assign ("recv_calls", octave_value (double (r->recv_calls)));
+  stats.assign ("ring_full", octave_value (double (r->ring_full)));
+  stats.assign ("running", octave_value (! r->done));
+  stats.assign ("error", octave_value (r->err.load ()));
+  return octave_value (stats);
+}
+
+// PKG_ADD: autoload ("recv_async_stop", which ("socket"));
+// PKG_DEL: try; autoload ("recv_async_stop", which ("socket"), "remove"); catch; end;
+// function to stop receiving in the background
+DEFUN_DLD(recv_async_stop, args, , "\
+-*- texinfo -*-\n\
+@deftypefn {Loadable Function} {} recv_async_stop (@var{s})\n\
+Stop receiving from specified socket in the background.\n\
+\n\
+Stops the thread started with @code{recv_async_start} and frees its ring\n\
+buffer.  Data not yet read with @code{recv_async_read} is lost.\n\
+@seealso{recv_async_start, recv_async_read, recv_async_stats}\n\
+@end deftypefn")
+{
+  if (args.length () != 1)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  // Determine the socket on which to operate
+  const int s = get_socket (args(0));
+  if (error_state)
+    {
+      error ("recv_async_stop: S must be a valid socket");
+      return octave_value ();
+    }
+
+  stop_async_reader (s);
+  return octave_value ();
+}
+#else
+DEFUNX_DLD ("recv_async_start", Frecv_async_start, Grecv_async_start, args, nargout, "(not supported)")
+{ error( "recv_async_start: not supported on this platform" );
+  return octave_value(); };
+DEFUNX_DLD ("recv_async_read", Frecv_async_read, Grecv_async_read, args, nargout, "(not supported)")
+{ error( "recv_async_read: not supported on this platform" );
+  return octave_value(); };
+DEFUNX_DLD ("recv_async_stats", Frecv_async_stats, Grecv_async_stats, args, nargout, "(not supported)")
+{ error( "recv_async_stats: not supported on this platform" );
+  return octave_value(); };
+DEFUNX_DLD ("recv_async_stop", Frecv_async_stop, Grecv_async_stop, args, nargout, "(not supported)")
+{ error( "recv_async_stop: not supported on this platform" );
+  return octave_value(); };
+#endif
+
+// PKG_ADD: autoload ("poll", which ("socket"));
+// PKG_DEL: try; autoload ("poll", which ("socket"), "remove"); catch; end;
+// function to wait for events on several sockets
+#ifndef __WIN32__
+DEFUN_DLD(poll, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {[@var{revents}, @var{count}] =} poll (@var{fds}, @var{events})\n\
+@deftypefnx {Loadable Function} {[@var{revents}, @var{count}] =} poll (@var{fds}, @var{events}, @var{timeout})\n\
+Wait for events on several sockets.\n\
+\n\
+Waits until one of the events in @var{events} occurs on any of the\n\
+sockets in the array @var{fds}.  @var{events} is either an array of the\n\
+same size as @var{fds} or a scalar applying to all of them, and is a\n\
+bitwise or of the constants @code{POLLIN}, @code{POLLPRI} and\n\
+@code{POLLOUT}.\n\
+\n\
+@var{timeout} is the maximum time to wait in milliseconds.  If it is\n\
+negative or not given, @code{poll} waits indefinitely.  Zero returns\n\
+immediately.\n\
+\n\
+The events that occurred on each socket are returned in @var{revents},\n\
+an array of the same size as @var{fds}.  Besides the requested events,\n\
+it may contain @code{POLLERR}, @code{POLLHUP} and @code{POLLNVAL}.  The\n\
+number of sockets with events is returned in @var{count}, which is zero\n\
+on timeout.\n\
+\n\
+For example, to serve whichever client sends data first:\n\
+\n\
+@example\n\
+@group\n\
+revents = poll (clients, POLLIN, 1000);\n\
+for c = clients(bitand (revents, POLLIN) != 0)\n\
+  data = recv (c, 4096);\n\
+  @dots{}\n\
+endfor\n\
+@end group\n\
+@end example\n\
+\n\
+See the @command{poll} man pages for further details.\n\
+@seealso{recv, accept}\n\
+@end deftypefn")
+{
+  const octave_idx_type nargin = args.length ();
+
+  if (nargin < 2 || nargin > 3)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  const Array<int> fds = get_socket_array (args(0));
+  if (error_state)
+    {
+      error ("poll: FDS must be an array or a cell array of sockets");
+      return octave_value ();
+    }
+
+  const Array<int> events = args(1).int_vector_value ();
+  if (error_state || (events.numel () != 1 && events.numel () != fds.numel ()))
+    {
+      error ("poll: EVENTS must be a scalar or match the size of FDS");
+      return octave_value ();
+    }
+
+  int timeout = -1;
+  if (nargin > 2)
+    {
+      timeout = args(2).int_value ();
+      if (error_state)
+        {
+          error ("poll: TIMEOUT must be an integer number of milliseconds");
+          return octave_value ();
+        }
+    }
+
+  const octave_idx_type n = fds.numel ();
+  std::vector<struct pollfd> pfds (n);
+  for (octave_idx_type i = 0; i < n; i++)
+    {
+      pfds[i].fd = fds(i);
+      pfds[i].events = events.numel () == 1 ? events(0) : events(i);
+      pfds[i].revents = 0;
+    }
+
+  // Wait in short slices so that Ctrl-C is honoured
+  const double deadline = timeout < 0 ? -1 : monotonic_time () + timeout * 1e-3;
+  int retval;
+  for (;;)
+    {
+      const int slice_ms = wait_slice_ms (deadline);
+      retval = ::poll (n > 0 ? &pfds[0] : 0, n, slice_ms);
+      if (retval > 0 || (retval == 0 && slice_ms == 0))
+        break;
+      else if (retval == -1 && errno != EINTR)
+        {
+          error ("poll failed with error %i (%s)", errno, strerror(errno));
+          return octave_value ();
+        }
+    }
+
+  NDArray revents (args(0).dims ());
+  for (octave_idx_type i = 0; i < n; i++)
+    revents(i) = pfds[i].revents;
+
+  octave_value_list return_list;
+  return_list(0) = revents;
+  return_list(1) = retval;
+  return return_list;
+}
+#else
+DEFUNX_DLD ("poll", Fpoll, Gpoll, args, nargout, "(not supported)")
+{ error( "poll: not supported on this platform" );
+  return octave_value(); };
+#endif
+
+/*
+ * The epoll event loop.  A loop is an epoll file descriptor, handed to
+ * octave as an integer like the sockets themselves.
+ */
+#ifdef __linux__
+/*
+ * helper function to convert an EVENTS argument to epoll event masks.
+ * These are read as doubles since EPOLLET, 2^31, does not fit in an
+ * int.  Returns false if an element is not a 32-bit unsigned integer.
+ */
+static bool get_event_masks (const octave_value& arg,
+                             std::vector<uint32_t>& masks)
+{
+  const NDArray a = arg.array_value ();
+  if (error_state)
+    return false;
+
+  masks.resize (a.numel ());
+  for (octave_idx_type i = 0; i < a.numel (); i++)
+    {
+      const double m = a(i);
+      if (! (m >= 0 && m <= std::numeric_limits<uint32_t>::max ())
+          || m != round (m))
+        return false;
+      masks[i] = uint32_t (m);
+    }
+  return true;
+}
+
+/*
+ * helper function to add, modify or delete the interest of the loop in
+ * the sockets FDS, for the functions evloop_add, evloop_mod and
+ * evloop_del.
+ */
+static octave_value evloop_ctl (const octave_value_list& args, int op,
+                                const char* who)
+{
+  const octave_idx_type nargin = args.length ();
+  if (nargin != (op == EPOLL_CTL_DEL ? 2 : 3))
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  const int loop = get_socket (args(0));
+  if (error_state)
+    {
+      error ("%s: LOOP must be an event loop", who);
+      return octave_value ();
+    }
+
+  const Array<int> fds = get_socket_array (args(1));
+  if (error_state)
+    {
+      error ("%s: FDS must be an array or a cell array of sockets", who);
+      return octave_value ();
+    }
+
+  std::vector<uint32_t> events;
+  if (op != EPOLL_CTL_DEL)
+    {
+      if (! get_event_masks (args(2), events)
+          || (events.size () != 1 && events.size () != size_t (fds.numel ())))
+        {
+          error ("%s: EVENTS must be a scalar or match the size of FDS", who);
+          return octave_value ();
+        }
+    }
+
+  for (octave_idx_type i = 0; i < fds.numel (); i++)
+    {
+      struct epoll_event ev;
+      memset (&ev, 0, sizeof (ev));
+      if (op != EPOLL_CTL_DEL)
+        ev.events = events.size () == 1 ? events[0] : events[i];
+      ev.data.fd = fds(i);
+      if (epoll_ctl (loop, op, fds(i), &ev) == -1)
+        {
+          error ("%s failed for socket %i with error %i (%s)", who, fds(i),
+                 errno, strerror(errno));
+          return octave_value ();
+        }
+    }
+
+  return octave_value (0);
+}
+#endif
+
+// PKG_ADD: autoload ("evloop_create", which ("socket"));
+// PKG_DEL: try; autoload ("evloop_create", which ("socket"), "remove"); catch; end;
+// function to create an event loop
+#ifdef __linux__
+DEFUN_DLD(evloop_create, args, , "\
+-*- texinfo -*-\n\
+@deftypefn {Loadable Function} {@var{loop} =} evloop_create ()\n\
+Create an event loop.\n\
+\n\
+Creates an event loop based on Linux epoll.  Unlike @code{poll}, the\n\
+loop keeps its set of sockets and requested events between waits, so\n\
+waiting costs the same no matter how many sockets are idle.  Sockets\n\
+are added with @code{evloop_add} and events are waited for with\n\
+@code{evloop_wait}.\n\
+\n\
+@var{loop} is a file descriptor.  Close it with @code{disconnect} when\n\
+it is no longer needed.\n\
+\n\
+See the @command{epoll} man pages for further details.\n\
+@seealso{evloop_add, evloop_mod, evloop_del, evloop_wait, poll}\n\
+@end deftypefn")
+{
+  if (args.length () != 0)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  const int loop = epoll_create1 (EPOLL_CLOEXEC);
+  if (loop == -1)
+    error ("evloop_create failed with error %i (%s)", errno, strerror(errno));
+
+  return octave_value (loop);
+}
+
+// PKG_ADD: autoload ("evloop_add", which ("socket"));
+// PKG_DEL: try; autoload ("evloop_add", which ("socket"), "remove"); catch; end;
+// function to add sockets to an event loop
+DEFUN_DLD(evloop_add, args, , "\
+-*- texinfo -*-\n\
+@deftypefn {Loadable Function} {} evloop_add (@var{loop}, @var{fds}, @var{events})\n\
+Add sockets to an event loop.\n\
+\n\
+Adds the sockets in the array @var{fds} to the event loop @var{loop}.\n\
+@var{events} is either an array of the same size as @var{fds} or a\n\
+scalar applying to all of them, and is a bitwise or of the constants\n\
+@code{EPOLLIN}, @code{EPOLLPRI}, @code{EPOLLOUT}, @code{EPOLLRDHUP},\n\
+@code{EPOLLET} and @code{EPOLLONESHOT}.\n\
+\n\
+With @code{EPOLLET} a socket is only reported when new data arrives\n\
+(edge-triggered), so it must be read until @code{recv} with\n\
+@code{MSG_DONTWAIT} returns no more data.\n\
+@seealso{evloop_create, evloop_mod, evloop_del, evloop_wait}\n\
+@end deftypefn")
+{
+  return evloop_ctl (args, EPOLL_CTL_ADD, "evloop_add");
+}
+
+// PKG_ADD: autoload ("evloop_mod", which ("socket"));
+// PKG_DEL: try; autoload ("evloop_mod", which ("socket"), "remove"); catch; end;
+// function to change the events waited for in an event loop
+DEFUN_DLD(evloop_mod, args, , "\
+-*- texinfo -*-\n\
+@deftypefn {Loadable Function} {} evloop_mod (@var{loop}, @var{fds}, @var{events})\n\
+Change the events waited for on sockets in an event loop.\n\
+\n\
+The arguments are the same as for @code{evloop_add}.  This is also used\n\
+to rearm sockets added with @code{EPOLLONESHOT}.\n\
+@seealso{evloop_create, evloop_add, evloop_del, evloop_wait}\n\
+@end deftypefn")
+{
+  return evloop_ctl (args, EPOLL_CTL_MOD, "evloop_mod");
+}
+
+// PKG_ADD: autoload ("evloop_del", which ("socket"));
+// PKG_DEL: try; autoload ("evloop_del", which ("socket"), "remove"); catch; end;
+// function to remove sockets from an event loop
+DEFUN_DLD(evloop_del, args, , "\
+-*- texinfo -*-\n\
+@deftypefn {Loadable Function} {} evloop_del (@var{loop}, @var{fds})\n\
+Remove sockets from an event loop.\n\
+\n\
+Removes the sockets in the array @var{fds} from the event loop\n\
+@var{loop}.  Closed sockets are removed automatically.\n\
+@seealso{evloop_create, evloop_add, evloop_mod, evloop_wait}\n\
+@end deftypefn")
+{
+  return evloop_ctl (args, EPOLL_CTL_DEL, "evloop_del");
+}
+
+// PKG_ADD: autoload ("evloop_wait", which ("socket"));
+// PKG_DEL: try; autoload ("evloop_wait", which ("socket"), "remove"); catch; end;
+// function to wait for events in an event loop
+DEFUN_DLD(evloop_wait, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {[@var{fds}, @var{events}] =} evloop_wait (@var{loop})\n\
+@deftypefnx {Loadable Function} {[@var{fds}, @var{events}] =} evloop_wait (@var{loop}, @var{max_events})\n\
+@deftypefnx {Loadable Function} {[@var{fds}, @var{events}] =} evloop_wait (@var{loop}, @var{max_events}, @var{timeout})\n\
+Wait for events in an event loop.\n\
+\n\
+Waits until events occur on sockets of the event loop @var{loop} and\n\
+returns at most @var{max_events} (64 by default) of them.  The ready\n\
+sockets are returned in the column vector @var{fds} and their events in\n\
+the column vector @var{events}.  Besides the requested events, these\n\
+may contain @code{EPOLLERR} and @code{EPOLLHUP}.\n\
+\n\
+@var{timeout} is the maximum time to wait in milliseconds.  If it is\n\
+negative or not given, @code{evloop_wait} waits indefinitely.  On\n\
+timeout, @var{fds} and @var{events} are empty.\n\
+@seealso{evloop_create, evloop_add, evloop_mod, evloop_del}\n\
+@end deftypefn")
+{
+  const octave_idx_type nargin = args.length ();
+
+  if (nargin < 1 || nargin > 3)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  const int loop = get_socket (args(0));
+  if (error_state)
+    {
+      error ("evloop_wait: LOOP must be an event loop");
+      return octave_value ();
+    }
+
+  int max_events = 64;
+  if (nargin > 1)
+    {
+      max_events = args(1).int_value ();
+      if (error_state || max_events < 1)
+        {
+          error ("evloop_wait: MAX_EVENTS must be a positive integer");
+          return octave_value ();
+        }
+    }
+
+  int timeout = -1;
+  if (nargin > 2)
+    {
+      timeout = args(2).int_value ();
+      if (error_state)
+        {
+          error ("evloop_wait: TIMEOUT must be an integer number of milliseconds");
+          return octave_value ();
+        }
+    }
+
+  std::vector<struct epoll_event> evs (max_events);
+
+  // Wait in short slices so that Ctrl-C is honoured
+  const double deadline = timeout < 0 ? -1 : monotonic_time () + timeout * 1e-3;
+  int n;
+  for (;;)
+    {
+      const int slice_ms = wait_slice_ms (deadline);
+      n = epoll_wait (loop, &evs[0], max_events, slice_ms);
+      if (n > 0 || (n == 0 && slice_ms == 0))
+        break;
+      else if (n == -1 && errno != EINTR)
+        {
+          error ("evloop_wait failed with error %i (%s)", errno,
+                 strerror(errno));
+          return octave_value ();
+        }
+    }
+
+  ColumnVector fds (n);
+  ColumnVector events (n);
+  for (int i = 0; i < n; i++)
+    {
+      fds(i) = evs[i].data.fd;
+      events(i) = evs[i].events;
+    }
+
+  octave_value_list return_list;
+  return_list(0) = fds;
+  return_list(1) = events;
+  return return_list;
+}
+#else
+DEFUNX_DLD ("evloop_create", Fevloop_create, Gevloop_create, args, nargout, "(not supported)")
+{ error( "evloop_create: not supported on this platform" );
+  return octave_value(); };
+DEFUNX_DLD ("evloop_add", Fevloop_add, Gevloop_add, args, nargout, "(not supported)")
+{ error( "evloop_add: not supported on this platform" );
+  return octave_value(); };
+DEFUNX_DLD ("evloop_mod", Fevloop_mod, Gevloop_mod, args, nargout, "(not supported)")
+{ error( "evloop_mod: not supported on this platform" );
+  return octave_value(); };
+DEFUNX_DLD ("evloop_del", Fevloop_del, Gevloop_del, args, nargout, "(not supported)")
+{ error( "evloop_del: not supported on this platform" );
+  return octave_value(); };
+DEFUNX_DLD ("evloop_wait", Fevloop_wait, Gevloop_wait, args, nargout, "(not supported)")
+{ error( "evloop_wait: not supported on this platform" );
+  return octave_value(); };
+#endif
+
+/*
+ * The io_uring engine.  A ring is the io_uring file descriptor, handed
+ * to octave as an integer like the event loops, and its state is kept
+ * in uring_states.
+ */
+#ifdef HAVE_IO_URING
+static inline int uring_enter (int ring_fd, unsigned to_submit,
+                               unsigned min_complete, unsigned flags)
+{
+  return syscall (__NR_io_uring_enter, ring_fd, to_submit, min_complete,
+                  flags, NULL, 0);
+}
+
+/*
+ * helper function to submit the operations queued on ring ST to the
+ * kernel.  Returns the number submitted, or -1 with errno set if none
+ * could be.
+ */
+static int uring_flush (uring_state* st)
+{
+  __atomic_store_n (st->sq_tail, st->sq_local_tail, __ATOMIC_RELEASE);
+  int submitted = 0;
+  for (;;)
+    {
+      const unsigned queued
+        = st->sq_local_tail - __atomic_load_n (st->sq_head, __ATOMIC_ACQUIRE);
+      if (queued == 0)
+        break;
+      const int n = uring_enter (st->fd, queued, 0, 0);
+      if (n == -1 && errno == EINTR)
+        continue;
+      else if (n == -1)
+        return submitted > 0 ? submitted : -1;
+      else if (n == 0)
+        break;
+      submitted += n;
+    }
+  return submitted;
+}
+
+/*
+ * helper function to get a cleared submission queue entry of ring ST,
+ * submitting the queued operations first if the queue is full.
+ * Returns 0 with errno set if that failed.
+ */
+static struct io_uring_sqe* uring_get_sqe (uring_state* st)
+{
+  if (st->sq_local_tail - __atomic_load_n (st->sq_head, __ATOMIC_ACQUIRE)
+      == st->sq_entries)
+    {
+      if (uring_flush (st) == -1)
+        return 0;
+      if (st->sq_local_tail - __atomic_load_n (st->sq_head, __ATOMIC_ACQUIRE)
+          == st->sq_entries)
+        {
+          errno = EBUSY;
+          return 0;
+        }
+    }
+
+  const unsigned idx = st->sq_local_tail & st->sq_mask;
+  struct io_uring_sqe* sqe = &st->sqes[idx];
+  memset (sqe, 0, sizeof (*sqe));
+  st->sq_array[idx] = idx;
+  st->sq_local_tail++;
+  return sqe;
+}
+
+/*
+ * helper function to queue the return of COUNT buffers of the pool of
+ * ring ST, starting with buffer BID, to the kernel.
+ */
+static bool uring_provide (uring_state* st, unsigned bid, unsigned count)
+{
+  struct io_uring_sqe* sqe = uring_get_sqe (st);
+  if (! sqe)
+    return false;
+  sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+  sqe->fd = count;
+  sqe->addr = reinterpret_cast<uintptr_t> (&st->pool[size_t (bid) * st->pool_size]);
+  sqe->len = st->pool_size;
+  sqe->off = bid;
+  sqe->buf_group = 0;
+  sqe->user_data = 0;
+  return true;
+}
+
+/*
+ * helper function to map the queues of the ring RING_FD set up with
+ * parameters P into ST.  Returns false with errno set if that failed.
+ */
+static bool uring_map (int ring_fd, const struct io_uring_params& p,
+                       uring_state* st)
+{
+  st->fd = ring_fd;
+  st->sq_entries = p.sq_entries;
+  st->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof (unsigned);
+  st->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof (struct io_uring_cqe);
+  if (p.features & IORING_FEAT_SINGLE_MMAP)
+    st->sq_ring_size = st->cq_ring_size
+      = std::max (st->sq_ring_size, st->cq_ring_size);
+  st->sqes_size = p.sq_entries * sizeof (struct io_uring_sqe);
+
+  st->sq_ring = mmap (0, st->sq_ring_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+  if (st->sq_ring == MAP_FAILED)
+    return false;
+  st->cq_ring = st->sq_ring;
+  if (! (p.features & IORING_FEAT_SINGLE_MMAP))
+    {
+      st->cq_ring = mmap (0, st->cq_ring_size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+      if (st->cq_ring == MAP_FAILED)
+        {
+          munmap (st->sq_ring, st->sq_ring_size);
+          return false;
+        }
+    }
+  void* sqes = mmap (0, st->sqes_size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED)
+    {
+      if (st->cq_ring != st->sq_ring)
+        munmap (st->cq_ring, st->cq_ring_size);
+      munmap (st->sq_ring, st->sq_ring_size);
+      return false;
+    }
+  st->sqes = static_cast<struct io_uring_sqe*> (sqes);
+
+  char* sq = static_cast<char*> (st->sq_ring);
+  st->sq_head = reinterpret_cast<unsigned*> (sq + p.sq_off.head);
+  st->sq_tail = reinterpret_cast<unsigned*> (sq + p.sq_off.tail);
+  st->sq_array = reinterpret_cast<unsigned*> (sq + p.sq_off.array);
+  st->sq_mask = *reinterpret_cast<unsigned*> (sq + p.sq_off.ring_mask);
+  st->sq_local_tail = *st->sq_tail;
+
+  char* cq = static_cast<char*> (st->cq_ring);
+  st->cq_head = reinterpret_cast<unsigned*> (cq + p.cq_off.head);
+  st->cq_tail = reinterpret_cast<unsigned*> (cq + p.cq_off.tail);
+  st->cqes = reinterpret_cast<struct io_uring_cqe*> (cq + p.cq_off.cqes);
+  st->cq_mask = *reinterpret_cast<unsigned*> (cq + p.cq_off.ring_mask);
+  return true;
+}
+
+/*
+ * helper function to get the state of the ring in ARG, setting
+ * error_state if it is not one.
+ */
+static uring_state* get_uring (const octave_value& arg, const char* who)
+{
+  const int ring_fd = get_socket (arg);
+  std::map<int, uring_state*>::iterator it = uring_states.find (ring_fd);
+  if (error_state || it == uring_states.end ())
+    {
+      error ("%s: RING must be a ring created by uring_create", who);
+      return 0;
+    }
+  return it->second;
+}
+#endif
+
+// PKG_ADD: autoload ("uring_create", which ("socket"));
+// PKG_DEL: try; autoload ("uring_create", which ("socket"), "remove"); catch; end;
+// function to create an io_uring
+#ifdef HAVE_IO_URING
+DEFUN_DLD(uring_create, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {@var{ring} =} uring_create ()\n\
+@deftypefnx {Loadable Function} {@var{ring} =} uring_create (@var{entries})\n\
+@deftypefnx {Loadable Function} {@var{ring} =} uring_create (@var{entries}, \"buffers\", [@var{count}, @var{size}])\n\
+Create an io_uring for batched socket operations.\n\
+\n\
+Creates a Linux io_uring with room for @var{entries} (256 by default)\n\
+queued operations.  Sends, receives and accepts on any number of\n\
+sockets are queued with @code{uring_queue}, handed to the kernel in one\n\
+system call with @code{uring_submit}, and their results are collected\n\
+with @code{uring_reap}.\n\
 \n\
-See the @command{gethostbyname} man pages for details.\n\
+With @qcode{\"buffers\"}, a pool of @var{count} buffers of @var{size}\n\
+bytes each is registered with the kernel.  Receives can then take a\n\
+buffer from the pool when data arrives, instead of reserving one when\n\
+they are queued, which multishot receives require.\n\
+\n\
+@var{ring} is a file descriptor.  Close it with @code{disconnect} when\n\
+it is no longer needed.  io_uring needs Linux 5.7; multishot accept\n\
+needs 5.19 and multishot receive 6.0.\n\
 \n\
+See the @command{io_uring} man pages for further details.\n\
+@seealso{uring_queue, uring_submit, uring_reap, evloop_create}\n\
 @end deftypefn")
 {
-  const int nargin = args.length ();
-
-  if (nargin != 1)
+  const octave_idx_type nargin = args.length ();
+  if (nargin != 0 && nargin != 1 && nargin != 3)
     {
       print_usage ();
       return octave_value ();
     }
 
-  const std::string addr = args(0).string_value ();
-  if (error_state)
+  int entries = 256;
+  if (nargin > 0)
     {
-      error ("gethostbyname: HOSTNAME must be a string");
+      entries = args(0).int_value ();
+      if (error_state || entries < 1)
+        {
+          error ("uring_create: ENTRIES must be a positive integer");
+          return octave_value ();
+        }
+    }
+
+  double pool_count = 0;
+  double pool_size = 0;
+  if (nargin > 2)
+    {
+      const NDArray pool = args(2).array_value ();
+      if (error_state || args(1).string_value () != "buffers"
+          || pool.numel () != 2)
+        {
+          error ("uring_create: expected \"buffers\" followed by [COUNT, SIZE]");
+          return octave_value ();
+        }
+      pool_count = pool(0);
+      pool_size = pool(1);
+      if (pool_count < 1 || pool_count > 65536
+          || pool_count != round (pool_count) || pool_size < 1
+          || pool_size > std::numeric_limits<int>::max ()
+          || pool_size != round (pool_size))
+        {
+          error ("uring_create: COUNT must be an integer from 1 to 65536 and SIZE a positive integer");
+          return octave_value ();
+        }
+    }
+
+  struct io_uring_params p;
+  memset (&p, 0, sizeof (p));
+  const int ring_fd = syscall (__NR_io_uring_setup, entries, &p);
+  if (ring_fd == -1)
+    {
+      error ("uring_create failed with error %i (%s)", errno, strerror(errno));
       return octave_value ();
     }
+  fcntl (ring_fd, F_SETFD, FD_CLOEXEC);
 
-  string_vector host_list;
-  struct hostent* hostInfo = gethostbyname (addr.c_str ());
-  if (hostInfo)
+  uring_state* st = new uring_state ();
+  if (! uring_map (ring_fd, p, st))
+    {
+      error ("uring_create failed with error %i (%s)", errno, strerror(errno));
+      delete st;
+      ::close (ring_fd);
+      return octave_value ();
+    }
+  st->next_tag = 1;
+  st->pool_count = pool_count;
+  st->pool_size = pool_size;
+  uring_states[ring_fd] = st;
+
+  // Hand the pool over and wait for the kernel to accept it
+  if (pool_count > 0)
     {
-      for (int i = 0 ; i < hostInfo->h_length/4; i++)
+      st->pool.resize (size_t (pool_count) * size_t (pool_size));
+      int rc = uring_provide (st, 0, st->pool_count) ? uring_flush (st) : -1;
+      while (rc != -1
+             && (rc = uring_enter (ring_fd, 0, 1, IORING_ENTER_GETEVENTS)) == -1
+             && errno == EINTR)
+        rc = 0;
+      if (rc != -1)
         {
-          std::string temp_addr = inet_ntoa (*(struct in_addr*)hostInfo->h_addr_list[i]);
-          host_list.append (temp_addr);
+          const unsigned head = *st->cq_head;
+          rc = st->cqes[head & st->cq_mask].res;
+          __atomic_store_n (st->cq_head, head + 1, __ATOMIC_RELEASE);
+          if (rc < 0)
+            errno = -rc;
+        }
+      if (rc < 0)
+        {
+          error ("uring_create: registering the buffers failed with error %i (%s)",
+                 errno, strerror(errno));
+          close_uring (ring_fd);
+          ::close (ring_fd);
+          return octave_value ();
         }
     }
-  return octave_value (host_list);
+
+  return octave_value (ring_fd);
 }
 
-// PKG_ADD: autoload ("send", which ("socket"));
-// PKG_DEL: try; autoload ("send", which ("socket"), "remove"); catch; end;
-// function to send data over a socket
-DEFUN_DLD(send, args, , "\
+// PKG_ADD: autoload ("uring_queue", which ("socket"));
+// PKG_DEL: try; autoload ("uring_queue", which ("socket"), "remove"); catch; end;
+// function to queue operations on an io_uring
+DEFUN_DLD(uring_queue, args, , "\
 -*- texinfo -*-\n\
-@deftypefn  {Loadable Function} {} send (@var{s}, @var{data})\n\
-@deftypefnx {Loadable Function} {} send (@var{s}, @var{data}, @var{flags})\n\
-Send data on specified socket.\n\
+@deftypefn  {Loadable Function} {@var{tags} =} uring_queue (@var{ring}, \"send\", @var{fds}, @var{data})\n\
+@deftypefnx {Loadable Function} {@var{tags} =} uring_queue (@var{ring}, \"recv\", @var{fds}, @var{len})\n\
+@deftypefnx {Loadable Function} {@var{tags} =} uring_queue (@var{ring}, \"accept\", @var{fds})\n\
+@deftypefnx {Loadable Function} {@var{tags} =} uring_queue (@dots{}, @var{property}, @var{value}, @dots{})\n\
+Queue socket operations on an io_uring.\n\
 \n\
-Sends data on socket @var{s}.  @var{data} should be an uint8 array or\n\
-a string.\n\
+Queues one operation for each socket in the array or cell array\n\
+@var{fds} on the ring @var{ring}, and returns an array of the same size\n\
+with the @var{tags} that @code{uring_reap} reports their results under.\n\
+Nothing happens until the operations are submitted with\n\
+@code{uring_submit} or @code{uring_reap}; if the queue of the ring\n\
+fills up, the operations queued so far are submitted.\n\
 \n\
-See the @command{send} man pages for further details.\n\
+@qcode{\"send\"} sends @var{data}, an array as accepted by @code{send}\n\
+or a cell array of one array per socket, in native byte order.\n\
+@qcode{\"recv\"} receives up to @var{len} bytes.  If @var{len} is 0,\n\
+a buffer is taken from the pool of the ring when data arrives.\n\
+@qcode{\"accept\"} accepts a connection on a listening socket.\n\
+\n\
+The properties are:\n\
 \n\
+@table @asis\n\
+@item @qcode{\"flags\"}\n\
+Flags for send and recv, as for @code{send} and @code{recv}.\n\
+\n\
+@item @qcode{\"multishot\"}\n\
+If true, an accept or a receive from the pool stays active and reports\n\
+a result for every connection or every piece of data, under the same\n\
+tag, until it fails or the socket is closed.\n\
+@end table\n\
+@seealso{uring_create, uring_submit, uring_reap}\n\
 @end deftypefn")
 {
   const octave_idx_type nargin = args.length ();
+  if (nargin < 3)
+    {
+      print_usage ();
+      return octave_value ();
+    }
 
-  if (nargin < 2 || nargin > 3)
-  {
-    print_usage ();
+  uring_state* st = get_uring (args(0), "uring_queue");
+  if (error_state)
     return octave_value ();
-  }
+
+  const std::string op = args(1).string_value ();
+  if (error_state || (op != "send" && op != "recv" && op != "accept"))
+    {
+      error ("uring_queue: OP must be \"send\", \"recv\" or \"accept\"");
+      return octave_value ();
+    }
+
+  const Array<int> fds = get_socket_array (args(2));
+  if (error_state)
+    {
+      error ("uring_queue: FDS must be an array or a cell array of sockets");
+      return octave_value ();
+    }
+  const octave_idx_type n = fds.numel ();
+
+  Cell data;
+  octave_idx_type len = 0;
+  octave_idx_type i = 3;
+  if (op == "send" && nargin > 3)
+    {
+      data = args(3).is_cell () ? args(3).cell_value () : Cell (args(3));
+      if (data.numel () != 1 && data.numel () != n)
+        {
+          error ("uring_queue: DATA must be an array or a cell array of one array per socket");
+          return octave_value ();
+        }
+      for (octave_idx_type j = 0; j < data.numel (); j++)
+        {
+          size_t nbytes, wordsize;
+          if (! get_raw_data (data(j), nbytes, wordsize))
+            {
+              error ("uring_queue: DATA must be numeric, logical or char arrays");
+              return octave_value ();
+            }
+        }
+      i++;
+    }
+  else if (op == "recv" && nargin > 3)
+    {
+      len = args(3).idx_type_value ();
+      if (error_state || len < 0)
+        {
+          error ("uring_queue: LEN must be a non-negative integer");
+          return octave_value ();
+        }
+      i++;
+    }
+  else if (op != "accept")
+    {
+      print_usage ();
+      return octave_value ();
+    }
 
   int flags = 0;
-  if (nargin > 2)
+  bool multishot = false;
+  if ((nargin - i) % 2 != 0)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+  for (; i < nargin; i += 2)
     {
-      flags = args(2).int_value ();
+      const std::string name = args(i).string_value ();
       if (error_state)
         {
-          error ("send: FLAGS must be a scalar integer");
+          error ("uring_queue: PROPERTY must be a string");
+          return octave_value ();
+        }
+      else if (name == "flags")
+        flags = args(i+1).int_value ();
+      else if (name == "multishot")
+        multishot = args(i+1).bool_value ();
+      else
+        {
+          error ("uring_queue: unknown property \"%s\"", name.c_str ());
+          return octave_value ();
+        }
+      if (error_state)
+        {
+          error ("uring_queue: invalid value for property \"%s\"", name.c_str ());
           return octave_value ();
         }
     }
 
-  // Determine the socket on which to operate
-  const int s = get_socket (args(0));
-  if (error_state)
+  const bool from_pool = (op == "recv" && len == 0);
+  if (from_pool && st->pool.empty ())
     {
-      error ("send: s must be a valid socket");
+      error ("uring_queue: receiving with LEN 0 needs a ring created with \"buffers\"");
       return octave_value ();
     }
-
-  int retval = -1;
-  // Extract the data from the octave variable and send it
-  const octave_base_value& data = args(1).get_rep ();
-  if (data.is_string ())
+  if (multishot && ! (op == "accept" || from_pool))
     {
-      std::string buf = data.string_value ();
-      retval = ::send (s, buf.c_str (), buf.length (), flags);
+      error ("uring_queue: only accept and recv with LEN 0 can be multishot");
+      return octave_value ();
     }
-  else if (data.byte_size () == size_t (data.numel ()))
+#if ! defined (IORING_ACCEPT_MULTISHOT) || ! defined (IORING_RECV_MULTISHOT)
+  if (multishot)
     {
-      const NDArray d1 = data.array_value ();
-      const octave_idx_type length = d1.numel ();
-      const double* d1fvec = d1.data ();
+      error ("uring_queue: multishot operations are not supported on this platform");
+      return octave_value ();
+    }
+#endif
 
-      OCTAVE_LOCAL_BUFFER (unsigned char, buf, length);
-      for (int i = 0 ; i < length; i++)
-        buf[i] = (unsigned char)d1fvec[i];
+  NDArray tags (fds.dims ());
+  for (octave_idx_type j = 0; j < n; j++)
+    {
+      struct io_uring_sqe* sqe = uring_get_sqe (st);
+      if (! sqe)
+        {
+          error ("uring_queue failed with error %i (%s)", errno, strerror(errno));
+          return octave_value ();
+        }
 
-      //hmm, flags are set to 0, unlike the call above!
-      retval = ::send (s, (const char*)buf, data.byte_size (), 0);
+      const uint64_t tag = st->next_tag++;
+      uring_op& o = st->ops[tag];
+      o.fd = fds(j);
+      o.multishot = multishot;
+      sqe->fd = fds(j);
+      sqe->user_data = tag;
+      if (op == "send")
+        {
+          o.kind = URING_SEND;
+          o.data = data(data.numel () == 1 ? 0 : j);
+          size_t nbytes, wordsize;
+          sqe->opcode = IORING_OP_SEND;
+          sqe->addr = reinterpret_cast<uintptr_t> (get_raw_data (o.data, nbytes,
+                                                                  wordsize));
+          sqe->len = nbytes;
+          sqe->msg_flags = flags;
+        }
+      else if (op == "recv")
+        {
+          o.kind = URING_RECV;
+          sqe->opcode = IORING_OP_RECV;
+          sqe->msg_flags = flags;
+          if (from_pool)
+            {
+              sqe->flags = IOSQE_BUFFER_SELECT;
+              sqe->buf_group = 0;
+#ifdef IORING_RECV_MULTISHOT
+              if (multishot)
+                sqe->ioprio = IORING_RECV_MULTISHOT;
+              else
+#endif
+                sqe->len = st->pool_size;
+            }
+          else
+            {
+              o.buf.resize (len);
+              sqe->addr = reinterpret_cast<uintptr_t> (len > 0 ? &o.buf[0] : 0);
+              sqe->len = len;
+            }
+        }
+      else
+        {
+          o.kind = URING_ACCEPT;
+          sqe->opcode = IORING_OP_ACCEPT;
+          sqe->accept_flags = SOCK_CLOEXEC;
+#ifdef IORING_ACCEPT_MULTISHOT
+          if (multishot)
+            sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+#endif
+        }
+      tags(j) = tag;
     }
-  else
+
+  return octave_value (tags);
+}
+
+// PKG_ADD: autoload ("uring_submit", which ("socket"));
+// PKG_DEL: try; autoload ("uring_submit", which ("socket"), "remove"); catch; end;
+// function to submit the operations queued on an io_uring
+DEFUN_DLD(uring_submit, args, , "\
+-*- texinfo -*-\n\
+@deftypefn {Loadable Function} {@var{n} =} uring_submit (@var{ring})\n\
+Submit the operations queued on an io_uring.\n\
+\n\
+Hands all operations queued with @code{uring_queue} on the ring\n\
+@var{ring} to the kernel in one system call, without waiting for them,\n\
+and returns their number @var{n}.\n\
+@seealso{uring_create, uring_queue, uring_reap}\n\
+@end deftypefn")
+{
+  if (args.length () != 1)
     {
-      error( "connect: invalid DATA to send.  Please format it prior to sending" );
+      print_usage ();
       return octave_value ();
     }
 
-  return octave_value (retval);
+  uring_state* st = get_uring (args(0), "uring_submit");
+  if (error_state)
+    return octave_value ();
+
+  const int n = uring_flush (st);
+  if (n == -1)
+    {
+      error ("uring_submit failed with error %i (%s)", errno, strerror(errno));
+      return octave_value ();
+    }
+  return octave_value (n);
 }
 
-// PKG_ADD: autoload ("recv", which ("socket"));
-// PKG_DEL: try; autoload ("recv", which ("socket"), "remove"); catch; end;
-// function to receive data over a socket
-DEFUN_DLD(recv, args, , "\
+// PKG_ADD: autoload ("uring_reap", which ("socket"));
+// PKG_DEL: try; autoload ("uring_reap", which ("socket"), "remove"); catch; end;
+// function to collect the results of operations on an io_uring
+DEFUN_DLD(uring_reap, args, , "\
 -*- texinfo -*-\n\
-@deftypefn  {Loadable Function} {[@var{data}, @var{count}] =} recv (@var{s}, @var{len})\n\
-@deftypefnx {Loadable Function} {[@var{data}, @var{count}] =} recv (@var{s}, @var{len}, @var{flags})\n\
-Read data from specified socket.\n\
-\n\
-Requests reading @var{len} bytes from the socket @var{s}.\n\
-The optional integer @var{flags} parameter can be used to modify the\n\
-behaviour of @code{recv}.\n\
-\n\
-The read data is returned in the uint8 array @var{data}.  The number of\n\
-bytes read is returned in @var{count}.\n\
+@deftypefn  {Loadable Function} {[@var{tags}, @var{results}, @var{data}, @var{more}] =} uring_reap (@var{ring})\n\
+@deftypefnx {Loadable Function} {[@dots{}] =} uring_reap (@var{ring}, @var{min_complete})\n\
+@deftypefnx {Loadable Function} {[@dots{}] =} uring_reap (@var{ring}, @var{min_complete}, @var{timeout})\n\
+Collect the results of operations on an io_uring.\n\
 \n\
-You can get non-blocking operation by using the flag @code{MSG_DONTWAIT}\n\
-which makes the @code{recv()} call return immediately.  If there is no\n\
-data, -1 is returned in count.\n\
+Submits the operations still queued on the ring @var{ring}, waits until\n\
+at least @var{min_complete} (0 by default) results are available, and\n\
+returns all available results in column vectors.  @var{tags} are the\n\
+tags returned by @code{uring_queue}.  @var{results} are the number of\n\
+bytes sent or received, or the descriptor of an accepted connection, or\n\
+a negative error number if the operation failed.\n\
 \n\
-See the @command{recv} man pages for further details.\n\
+The cell array @var{data} holds the received bytes as uint8 row vectors\n\
+for receives, and the accepted sockets, owning their descriptors like\n\
+the ones of @code{accept}, for accepts.  It is empty for sends.\n\
+@var{more} is true where a multishot operation stays active.  A receive from the pool ends\n\
+with the error ENOBUFS when the pool is exhausted, and has to be queued\n\
+again.  Buffers are returned to the pool with the next submission.\n\
 \n\
+@var{timeout} is the maximum time to wait in milliseconds.  If it is\n\
+negative or not given, @code{uring_reap} waits indefinitely.\n\
+@seealso{uring_create, uring_queue, uring_submit}\n\
 @end deftypefn")
 {
   const octave_idx_type nargin = args.length ();
-  int retval = 0;
-  int flags = 0;
-
-  if (nargin < 2 || nargin > 3)
+  if (nargin < 1 || nargin > 3)
     {
       print_usage ();
       return octave_value ();
     }
 
+  uring_state* st = get_uring (args(0), "uring_reap");
+  if (error_state || ! load_socket_type ("uring_reap"))
+    return octave_value ();
+
+  int min_complete = 0;
+  if (nargin > 1)
+    {
+      min_complete = args(1).int_value ();
+      if (error_state || min_complete < 0)
+        {
+          error ("uring_reap: MIN_COMPLETE must be a non-negative integer");
+          return octave_value ();
+        }
+    }
+
+  int timeout = -1;
   if (nargin > 2)
     {
-      flags = args(2).int_value ();
+      timeout = args(2).int_value ();
       if (error_state)
         {
-          error ("recv: FLAGS must be a scalar integer");
+          error ("uring_reap: TIMEOUT must be an integer number of milliseconds");
           return octave_value ();
         }
     }
 
-  // Determine the socket on which to operate
-  const int s = get_socket (args(0));
-  if (error_state)
+  if (uring_flush (st) == -1)
     {
-      error ("recv: S must be a valid socket");
+      error ("uring_reap: submitting failed with error %i (%s)", errno,
+             strerror(errno));
       return octave_value ();
     }
 
-  const long len = args(1).int_value ();
-  if (error_state || len < 0)
+  std::vector<double> tags;
+  std::vector<double> results;
+  std::vector<octave_value> data;
+  std::vector<bool> more;
+
+  // The ring is readable while it has completions
+  const double deadline = timeout < 0 ? -1 : monotonic_time () + timeout * 1e-3;
+  for (;;)
     {
-      error ("recv: LEN must be a non-negative integer");
-      return octave_value(-1);
-    }
+      unsigned head = *st->cq_head;
+      const unsigned tail = __atomic_load_n (st->cq_tail, __ATOMIC_ACQUIRE);
+      for (; head != tail; head++)
+        {
+          const struct io_uring_cqe cqe = st->cqes[head & st->cq_mask];
+          std::map<uint64_t, uring_op>::iterator it = st->ops.find (cqe.user_data);
+          if (cqe.user_data == 0 || it == st->ops.end ())
+            continue;
 
-  OCTAVE_LOCAL_BUFFER (unsigned char, buf, len);
-#ifndef __WIN32__
-  retval = ::recv( s, buf, len, flags );
-#else
-  retval = ::recv( s, ( char* )buf, len, flags );
+          uring_op& o = it->second;
+          octave_value d = Matrix ();
+          if (o.kind == URING_RECV)
+            {
+              const char* buf = o.buf.empty () ? 0 : &o.buf[0];
+              const bool pooled = cqe.flags & IORING_CQE_F_BUFFER;
+              const unsigned bid = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+              if (pooled)
+                buf = &st->pool[size_t (bid) * st->pool_size];
+              const octave_idx_type nbytes = std::max (cqe.res, 0);
+              uint8NDArray bytes (dim_vector (1, nbytes));
+              if (nbytes > 0)
+                memcpy (bytes.fortran_vec (), buf, nbytes);
+              d = bytes;
+              // Only give the buffer back once copied, as providing it
+              // may submit right away
+              if (pooled)
+                uring_provide (st, bid, 1);
+            }
+          else if (o.kind == URING_ACCEPT && cqe.res >= 0)
+            d = octave_value (new octave_socket (cqe.res, socket_family (o.fd),
+                                                 socket_type (o.fd), 0));
+          if (o.kind != URING_ACCEPT)
+            count_bytes (o.fd, cqe.res, o.kind == URING_SEND);
+
+          bool active = false;
+#ifdef IORING_CQE_F_MORE
+          active = o.multishot && (cqe.flags & IORING_CQE_F_MORE);
 #endif
+          tags.push_back (cqe.user_data);
+          results.push_back (cqe.res);
+          data.push_back (d);
+          more.push_back (active);
+          if (! active)
+            st->ops.erase (it);
+        }
+      __atomic_store_n (st->cq_head, head, __ATOMIC_RELEASE);
 
-  if (retval == -1)
-    warning ("recv error %i (%s)", errno, strerror(errno));
+      if (tags.size () >= size_t (min_complete))
+        break;
 
-  octave_value_list return_list;
-  uint8NDArray data;
+      const int slice_ms = wait_slice_ms (deadline);
+      struct pollfd pfd;
+      pfd.fd = st->fd;
+      pfd.events = POLLIN;
+      pfd.revents = 0;
+      const int rc = ::poll (&pfd, 1, slice_ms);
+      if (rc == -1 && errno != EINTR)
+        {
+          error ("uring_reap: poll failed with error %i (%s)", errno,
+                 strerror(errno));
+          return octave_value ();
+        }
+      else if (rc == 0 && slice_ms == 0)
+        break;
+    }
 
-  //always return the status in the second output parameter
-  return_list(1) = retval;
-  if (retval <= 0)
-    // We get -1 if an error occurs, or if there is no data and the
-    // socket is non-blocking. We should return in both cases.
-    // We get 0 if the peer has shut down.
-    return_list(0) = data;
-  else
+  const octave_idx_type n = tags.size ();
+  ColumnVector tag_vec (n);
+  ColumnVector result_vec (n);
+  Cell data_cell (dim_vector (n, 1));
+  boolNDArray more_vec (dim_vector (n, 1));
+  for (octave_idx_type i = 0; i < n; i++)
     {
-      //Normal behaviour. Copy the buffer to the output variable. For
-      //backward compatibility, a row vector is returned.
-      data.resize (dim_vector (1, retval));
-      octave_uint8* data_fvec = data.fortran_vec ();
-      for (int i = 0 ; i < retval ; i++)
-        data_fvec[i] = buf[i];
-
-      return_list(0) = data;
+      tag_vec(i) = tags[i];
+      result_vec(i) = results[i];
+      data_cell(i) = data[i];
+      more_vec(i) = more[i];
     }
+
+  octave_value_list return_list;
+  return_list(0) = tag_vec;
+  return_list(1) = result_vec;
+  return_list(2) = data_cell;
+  return_list(3) = more_vec;
   return return_list;
 }
+#else
+DEFUNX_DLD ("uring_create", Furing_create, Guring_create, args, nargout, "(not supported)")
+{ error( "uring_create: not supported on this platform" );
+  return octave_value(); };
+DEFUNX_DLD ("uring_queue", Furing_queue, Guring_queue, args, nargout, "(not supported)")
+{ error( "uring_queue: not supported on this platform" );
+  return octave_value(); };
+DEFUNX_DLD ("uring_submit", Furing_submit, Guring_submit, args, nargout, "(not supported)")
+{ error( "uring_submit: not supported on this platform" );
+  return octave_value(); };
+DEFUNX_DLD ("uring_reap", Furing_reap, Guring_reap, args, nargout, "(not supported)")
+{ error( "uring_reap: not supported on this platform" );
+  return octave_value(); };
+#endif
 
 // PKG_ADD: autoload ("bind", which ("socket"));
 // PKG_DEL: try; autoload ("bind", which ("socket"), "remove"); catch; end;
 // function to bind a socket
 DEFUN_DLD(bind, args, , "\
 -*- texinfo -*-\n\
-@deftypefn {Loadable Function} {} bind (@var{s}, @var{portnumber})\n\
+@deftypefn  {Loadable Function} {} bind (@var{s}, @var{portnumber})\n\
+@deftypefnx {Loadable Function} {} bind (@var{s}, @var{addr})\n\
+@deftypefnx {Loadable Function} {} bind (@var{s}, @var{path})\n\
 Bind specific socket to port number.\n\
 \n\
+With @var{portnumber}, the socket is bound to that port on any local\n\
+address.  @var{addr} is a struct with the fields @code{addr} and\n\
+@code{port}, as for @code{connect}, to bind to one local address only,\n\
+such as the one of a given interface.  An empty or missing @code{addr}\n\
+means any address.  The optional field @code{family} overrides the\n\
+address family of the socket to interpret @code{addr}.\n\
+\n\
+To share a port between several sockets, or processes, each of which\n\
+accepts part of the connections, set the SO_REUSEPORT option of all\n\
+of them before binding, see @code{reuseport_steer}.\n\
+\n\
+AF_UNIX sockets are bound to the file @var{path}, which must not exist\n\
+yet and is not removed when the socket is closed, or to a name in the\n\
+abstract namespace of Linux if @var{path} starts with @qcode{\"@@\"}.\n\
+@var{addr} may also give the path in field @code{addr}.\n\
+\n\
 See the @command{bind} man pages for further details.\n\
 \n\
 @end deftypefn")
@@ -613,25 +8347,187 @@ See the @command{bind} man pages for further details.\n\
       return octave_value ();
     }
 
-  const long port = args(1).int_value ();
-  if (error_state)
+  struct sockaddr_storage serverInfo;
+  socklen_t serverLen;
+  if (socket_family (s) == AF_UNIX)
     {
-      error ("bind: PORT must be a scalar integer");
-      return octave_value ();
+      serverLen = get_sockaddr (args(1), socket_family (s), serverInfo,
+                                "bind", "PATH");
+      if (error_state)
+        return octave_value ();
     }
+  else if (args(1).is_map ())
+    {
+      const octave_scalar_map info = args(1).scalar_map_value ();
+      int family = socket_family (s);
+      if (! error_state && info.isfield ("family"))
+        family = info.getfield ("family").int_value ();
+      if (error_state)
+        {
+          error ("bind: ADDR must be a struct with an integer family field");
+          return octave_value ();
+        }
 
-  struct sockaddr_in serverInfo;
-  serverInfo.sin_family = AF_INET;
-  serverInfo.sin_port = htons (port);
-  serverInfo.sin_addr.s_addr = INADDR_ANY;
+      // Without an address, bind to any address on the port
+      if (! info.isfield ("addr") || info.getfield ("addr").is_empty ())
+        {
+          const int port = info.getfield ("port").int_value ();
+          if (error_state)
+            {
+              error ("bind: ADDR must have an integer port field");
+              return octave_value ();
+            }
+          serverLen = any_sockaddr (family, port, serverInfo);
+        }
+      else
+        serverLen = get_sockaddr (args(1), family, serverInfo, "bind", "ADDR");
+      if (error_state)
+        return octave_value ();
+    }
+  else
+    {
+      const long port = args(1).int_value ();
+      if (error_state)
+        {
+          error ("bind: PORT must be a scalar integer or ADDR a struct");
+          return octave_value ();
+        }
+      serverLen = any_sockaddr (socket_family (s), port, serverInfo);
+    }
 
-  int retval = ::bind (s, (struct sockaddr *)&serverInfo, sizeof (serverInfo));
+  int retval = ::bind (s, (struct sockaddr *)&serverInfo, serverLen);
   if (retval == -1)
       error ("bind failed with error %i (%s)", errno, strerror(errno));
 
   return octave_value (retval);
 }
 
+// PKG_ADD: autoload ("reuseport_steer", which ("socket"));
+// PKG_DEL: try; autoload ("reuseport_steer", which ("socket"), "remove"); catch; end;
+// function to steer connections between sockets sharing a port
+#if defined (__linux__) && defined (SO_ATTACH_REUSEPORT_CBPF)
+DEFUN_DLD(reuseport_steer, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {} reuseport_steer (@var{s}, \"cpu\", @var{n})\n\
+@deftypefnx {Loadable Function} {} reuseport_steer (@var{s}, \"rxhash\", @var{n})\n\
+@deftypefnx {Loadable Function} {} reuseport_steer (@var{s}, @var{prog})\n\
+@deftypefnx {Loadable Function} {} reuseport_steer (@var{s}, \"none\")\n\
+Choose which socket of a SO_REUSEPORT group gets each connection.\n\
+\n\
+Sockets, in one or more processes, that set SO_REUSEPORT before binding\n\
+to the same address and port form a group among which the kernel\n\
+spreads incoming connections, by default by a hash of the addresses.\n\
+This attaches a classic BPF program to the group of socket @var{s} that\n\
+returns the index of the socket to use, in the order the sockets were\n\
+bound.\n\
+\n\
+With \"cpu\", the connection goes to socket number @code{mod (cpu,\n\
+@var{n})} where cpu is the CPU that received it, which keeps each worker\n\
+on the packets of its own CPU when interrupts are spread over CPUs.\n\
+With \"rxhash\", it goes to @code{mod (hash, @var{n})} using the hash\n\
+computed by the network card.  @var{n} is the number of sockets in the\n\
+group.\n\
+\n\
+@var{prog} can also be a custom program given as a matrix with one\n\
+instruction @code{[code, jt, jf, k]} per row, as for\n\
+@code{SO_ATTACH_REUSEPORT_CBPF}.  \"none\" removes the program.\n\
+\n\
+This function is only available on Linux.  eBPF programs are not\n\
+supported.\n\
+@end deftypefn")
+{
+  const octave_idx_type nargin = args.length ();
+  if (nargin != 2 && nargin != 3)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  const int s = get_socket (args(0));
+  if (error_state)
+    {
+      error ("reuseport_steer: S must be a valid socket");
+      return octave_value ();
+    }
+
+  std::vector<struct sock_filter> code;
+  if (args(1).is_string ())
+    {
+      const std::string mode = args(1).string_value ();
+      if (mode == "none")
+        {
+#ifdef SO_DETACH_REUSEPORT_BPF
+          int dummy = 0;
+          if (setsockopt (s, SOL_SOCKET, SO_DETACH_REUSEPORT_BPF, &dummy,
+                          sizeof (dummy)) == -1)
+            error ("reuseport_steer failed with error %i (%s)", errno,
+                   strerror(errno));
+#else
+          error ("reuseport_steer: removing a program is not supported on this system");
+#endif
+          return octave_value ();
+        }
+
+      int ancillary;
+      if (mode == "cpu")
+        ancillary = SKF_AD_CPU;
+      else if (mode == "rxhash")
+        ancillary = SKF_AD_RXHASH;
+      else
+        {
+          error ("reuseport_steer: unknown mode \"%s\"", mode.c_str ());
+          return octave_value ();
+        }
+
+      const int n = nargin > 2 ? args(2).int_value () : 0;
+      if (error_state || nargin != 3 || n < 1)
+        {
+          error ("reuseport_steer: N must be a positive integer");
+          return octave_value ();
+        }
+
+      // A = ancillary value; A = A % n; return A
+      const struct sock_filter prog[] =
+        {
+          { BPF_LD | BPF_W | BPF_ABS, 0, 0, uint32_t (SKF_AD_OFF + ancillary) },
+          { BPF_ALU | BPF_MOD | BPF_K, 0, 0, uint32_t (n) },
+          { BPF_RET | BPF_A, 0, 0, 0 }
+        };
+      code.assign (prog, prog + sizeof (prog) / sizeof (prog[0]));
+    }
+  else
+    {
+      const Matrix m = args(1).matrix_value ();
+      if (error_state || m.columns () != 4 || m.rows () < 1)
+        {
+          error ("reuseport_steer: PROG must be a matrix with 4 columns");
+          return octave_value ();
+        }
+      code.resize (m.rows ());
+      for (octave_idx_type i = 0; i < m.rows (); i++)
+        {
+          code[i].code = m(i,0);
+          code[i].jt = m(i,1);
+          code[i].jf = m(i,2);
+          code[i].k = m(i,3);
+        }
+    }
+
+  struct sock_fprog fprog;
+  fprog.len = code.size ();
+  fprog.filter = &code[0];
+  if (setsockopt (s, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &fprog,
+                  sizeof (fprog)) == -1)
+    error ("reuseport_steer failed with error %i (%s)", errno, strerror(errno));
+
+  return octave_value ();
+}
+#else
+DEFUNX_DLD ("reuseport_steer", Freuseport_steer, Greuseport_steer, args, nargout, "(not supported)")
+{ error( "reuseport_steer: not supported on this platform" );
+  return octave_value(); };
+#endif
+
 // PKG_ADD: autoload ("listen", which ("socket"));
 // PKG_DEL: try; autoload ("listen", which ("socket"), "remove"); catch; end;
 // function to listen on a socket
@@ -687,15 +8583,21 @@ DEFUN_DLD(accept,args,nargout, "\
 Accept incoming connection on specified socket.\n\
 \n\
 Accepts an incoming connection on the socket @var{s}.\n\
-The newly created socket is returned in @var{client}, and\n\
-associated information in a struct info.\n\
+The newly created socket is returned in @var{client}, owning its\n\
+descriptor like the ones of @code{socket}, and associated information in a\n\
+struct info.  Its fields @code{addr} and @code{port} hold the numeric\n\
+IPv4 or IPv6 address and the port of the peer, as accepted by\n\
+@code{connect}.  The fields @code{sin_family}, @code{sin_addr} and\n\
+@code{sin_port}, the latter in network byte order, are kept for\n\
+compatibility.\n\
 \n\
 See the @command{accept} man pages for further details.\n\
 \n\
 @end deftypefn")
 {
-  struct sockaddr_in clientInfo;
-  socklen_t clientLen = sizeof (struct sockaddr_in);
+  struct sockaddr_storage clientInfo;
+  memset (&clientInfo, 0, sizeof (clientInfo));
+  socklen_t clientLen = sizeof (clientInfo);
 
   if (args.length () != 1)
     {
@@ -711,34 +8613,214 @@ See the @command{accept} man pages for further details.\n\
       return octave_value ();
     }
 
+  if (! load_socket_type ("accept"))
+    return octave_value ();
+
+  const double t0 = io_clock ();
 #ifndef __WIN32__
   int fd = ::accept( s, (struct sockaddr *)&clientInfo, &clientLen );
 #else
   int fd = ::accept( s, (struct sockaddr *)&clientInfo, ( int* )&clientLen );
 #endif
+  count_call (s, IO_ACCEPT, fd == -1, false, t0);
   if (fd == -1)
     {
       error ("accept failed with error %i (%s)", errno, strerror(errno));
       return octave_value ();
     }
 
-#if 0
-  // create the octave_socket object and set the fd
-  octave_socket* retobj = new octave_socket(fd);
-#endif
   // place the client information into a structure
   octave_scalar_map client_info_map;
-  client_info_map.assign ("sin_family", octave_value (clientInfo.sin_family));
-  client_info_map.assign ("sin_port", octave_value (clientInfo.sin_port));
-  client_info_map.assign ("sin_addr", octave_value (inet_ntoa(clientInfo.sin_addr)));
+  // sin_port keeps the network byte order it always had
+  const octave_scalar_map addr_map = sockaddr_to_map (clientInfo);
+  client_info_map.assign ("sin_family", octave_value (int (clientInfo.ss_family)));
+  client_info_map.assign ("sin_port", octave_value (int (htons (sockaddr_port (clientInfo)))));
+  client_info_map.assign ("sin_addr", addr_map.getfield ("addr"));
+  client_info_map.assign ("addr", addr_map.getfield ("addr"));
+  client_info_map.assign ("port", addr_map.getfield ("port"));
 
   // returns the accepted socket and a clientinfo structure
   octave_value_list return_list;
-  return_list(0) = octave_value (fd);
+  return_list(0) = octave_value (new octave_socket (fd, clientInfo.ss_family,
+                                                    socket_type (s), 0));
   return_list(1) = client_info_map;
 
+  socket_state& st = socket_states[fd];
+  st.have_peer = true;
+  st.peer = clientInfo;
+
+  return return_list;
+}
+
+// PKG_ADD: autoload ("accept_many", which ("socket"));
+// PKG_DEL: try; autoload ("accept_many", which ("socket"), "remove"); catch; end;
+// function to accept all pending connections
+#ifndef __WIN32__
+DEFUN_DLD(accept_many, args, , "\
+-*- texinfo -*-\n\
+@deftypefn  {Loadable Function} {[@var{clients}, @var{info}] =} accept_many (@var{s})\n\
+@deftypefnx {Loadable Function} {[@var{clients}, @var{info}] =} accept_many (@var{s}, @var{max})\n\
+@deftypefnx {Loadable Function} {[@var{clients}, @var{info}] =} accept_many (@var{s}, @var{max}, @var{timeout})\n\
+Accept all pending connections on specified socket.\n\
+\n\
+Accepts the connections waiting in the backlog of the listening socket\n\
+@var{s}, at most @var{max} of them (all by default), and returns\n\
+without blocking once the backlog is empty.  With @var{timeout}, waits\n\
+up to @var{timeout} milliseconds, or forever if it is negative, for a\n\
+first connection.\n\
+\n\
+The accepted sockets are returned in the column cell array\n\
+@var{clients}, owning their descriptors like the ones of @code{accept},\n\
+already non-blocking and closed on exec.  @var{info} is a struct array\n\
+of the same size with the fields @code{family}, @code{addr} and\n\
+@code{port} of the peers, the port in host byte order.\n\
+@seealso{accept, listen, poll}\n\
+@end deftypefn")
+{
+  const octave_idx_type nargin = args.length ();
+  if (nargin < 1 || nargin > 3)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  const int s = get_socket (args(0));
+  if (error_state)
+    {
+      error ("accept_many: S must be a valid socket");
+      return octave_value ();
+    }
+
+  if (! load_socket_type ("accept_many"))
+    return octave_value ();
+
+  octave_idx_type max_fds = std::numeric_limits<octave_idx_type>::max ();
+  if (nargin > 1 && ! args(1).is_empty ())
+    {
+      max_fds = args(1).idx_type_value ();
+      if (error_state || max_fds < 1)
+        {
+          error ("accept_many: MAX must be a positive integer");
+          return octave_value ();
+        }
+    }
+
+  int timeout = 0;
+  if (nargin > 2)
+    {
+      timeout = args(2).int_value ();
+      if (error_state)
+        {
+          error ("accept_many: TIMEOUT must be an integer number of milliseconds");
+          return octave_value ();
+        }
+    }
+
+  if (timeout != 0)
+    {
+      const double deadline = timeout < 0 ? -1 : monotonic_time () + timeout * 1e-3;
+      if (wait_socket (s, false, deadline) == -1)
+        {
+          error ("accept_many failed with error %i (%s)", errno, strerror(errno));
+          return octave_value ();
+        }
+    }
+
+  // The listening socket must not block once the backlog is drained
+  const int was_nonblocking = set_nonblocking (s, true);
+  if (was_nonblocking == -1)
+    {
+      error ("accept_many failed with error %i (%s)", errno, strerror(errno));
+      return octave_value ();
+    }
+
+  std::vector<int> fds;
+  std::vector<struct sockaddr_storage> peers;
+  int err = 0;
+  while (octave_idx_type (fds.size ()) < max_fds)
+    {
+      struct sockaddr_storage peer;
+      memset (&peer, 0, sizeof (peer));
+      socklen_t peer_len = sizeof (peer);
+      const double t0 = io_clock ();
+#if defined (SOCK_NONBLOCK) && defined (SOCK_CLOEXEC)
+      const int fd = accept4 (s, (struct sockaddr*)&peer, &peer_len,
+                              SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+      const int fd = ::accept (s, (struct sockaddr*)&peer, &peer_len);
+      if (fd != -1)
+        {
+          fcntl (fd, F_SETFL, fcntl (fd, F_GETFL, 0) | O_NONBLOCK);
+          fcntl (fd, F_SETFD, FD_CLOEXEC);
+        }
+#endif
+      count_call (s, IO_ACCEPT, fd == -1, false, t0);
+      if (fd == -1)
+        {
+          // A connection reset while in the backlog is skipped
+          if (errno == EINTR || errno == ECONNABORTED)
+            continue;
+          if (errno != EAGAIN && errno != EWOULDBLOCK)
+            err = errno;
+          break;
+        }
+
+      fds.push_back (fd);
+      peers.push_back (peer);
+    }
+
+  if (! was_nonblocking)
+    set_nonblocking (s, false);
+
+  // Only fail if nothing was accepted, so that no descriptor is lost
+  if (err != 0 && fds.empty ())
+    {
+      error ("accept_many failed with error %i (%s)", err, strerror(err));
+      return octave_value ();
+    }
+
+  const int type = socket_type (s);
+  const octave_idx_type n = fds.size ();
+  Cell clients (dim_vector (n, 1));
+  Cell family (dim_vector (n, 1));
+  Cell addr (dim_vector (n, 1));
+  Cell port (dim_vector (n, 1));
+  for (octave_idx_type i = 0; i < n; i++)
+    {
+      const octave_scalar_map peer = sockaddr_to_map (peers[i]);
+      clients(i) = octave_value (new octave_socket (fds[i], peers[i].ss_family,
+                                                    type, 0));
+      socket_state& st = socket_states[fds[i]];
+      st.have_peer = true;
+      st.peer = peers[i];
+      family(i) = int (peers[i].ss_family);
+      addr(i) = peer.getfield ("addr");
+      port(i) = peer.getfield ("port");
+    }
+  octave_map info (dim_vector (n, 1));
+  info.assign ("family", family);
+  info.assign ("addr", addr);
+  info.assign ("port", port);
+
+  octave_value_list return_list;
+  return_list(0) = clients;
+  return_list(1) = info;
   return return_list;
 }
+#else
+DEFUNX_DLD ("accept_many", Faccept_many, Gaccept_many, args, nargout, "(not supported)")
+{ error( "accept_many: not supported on this platform" );
+  return octave_value(); };
+#endif
+
+/*
+ * helper function telling whether option OPT at LEVEL is a timeout,
+ * given to octave in seconds.
+ */
+static bool is_timeout_opt (int level, int opt)
+{
+  return level == SOL_SOCKET && (opt == SO_RCVTIMEO || opt == SO_SNDTIMEO);
+}
 
 // PKG_ADD: autoload ("setsockopt", which ("socket"));
 // PKG_DEL: try; autoload ("setsockopt", which ("socket"), "remove"); catch; end;
@@ -750,8 +8832,9 @@ Set options for specified socket.\n\
 \n\
 Manipulates options for the socket @var{s}.\n\
 Options may exist at multiple protocol levels; they are always present\n\
-at the uppermost socket level. Currently only SOL_SOCKET is supported for\n\
-@var{level}. Supported values for @var{opt} are:\n\
+at the uppermost socket level. Currently SOL_SOCKET, IPPROTO_TCP and\n\
+IPPROTO_IPV6 are supported for @var{level}.  @var{value} is an integer,\n\
+unless stated otherwise.  Supported values for @var{opt} are:\n\
 @table @code\n\
 @item SO_DEBUG\n\
 Turns on recording of debugging information. This option enables or disables\n\
@@ -760,7 +8843,65 @@ debugging in the underlying protocol modules.\n\
 @item SO_REUSEADDR\n\
 Specifies that the rules used in validating addresses supplied to bind()\n\
 should allow reuse of local addresses, if this is supported by the protocol.\n\
+\n\
+@item SO_REUSEPORT\n\
+Allows several sockets to bind to the same address and port, the\n\
+kernel spreading connections or datagrams between them, see\n\
+@code{reuseport_steer}.\n\
+\n\
+@item SO_KEEPALIVE\n\
+Sends keep-alive probes on an idle connection, to detect peers that\n\
+vanished without closing it.\n\
+\n\
+@item SO_SNDBUF\n\
+@itemx SO_RCVBUF\n\
+The size in bytes of the send and receive buffers of the kernel.  Linux\n\
+doubles the value set and reports the doubled value.\n\
+\n\
+@item SO_RCVLOWAT\n\
+The minimum number of bytes that make a socket readable.\n\
+\n\
+@item SO_RCVTIMEO\n\
+@itemx SO_SNDTIMEO\n\
+The time in seconds, a double, after which a blocking receive or send\n\
+gives up.  0 means never.\n\
+\n\
+@item SO_LINGER\n\
+A struct with the fields @code{onoff}, true to make closing the socket\n\
+wait for unsent data to be sent, and @code{linger}, the maximum time to\n\
+wait in seconds.\n\
+\n\
+@item SO_BUSY_POLL\n\
+The time in microseconds to busy poll the device when receiving with\n\
+no data available, trading CPU time for latency (Linux only).\n\
+\n\
+@item TCP_NODELAY\n\
+At level IPPROTO_TCP, sends small segments at once instead of\n\
+collecting them (Nagle's algorithm).  Request/response protocols want\n\
+this set.\n\
+\n\
+@item TCP_QUICKACK\n\
+At level IPPROTO_TCP, acknowledges at once instead of delaying the ACK.\n\
+The kernel clears it again after some time (Linux only).\n\
+\n\
+@item TCP_CORK\n\
+At level IPPROTO_TCP, holds back partial segments until it is cleared\n\
+(Linux only).\n\
+\n\
+@item TCP_KEEPIDLE\n\
+@itemx TCP_KEEPINTVL\n\
+@itemx TCP_KEEPCNT\n\
+At level IPPROTO_TCP, the seconds of idleness before the first\n\
+keep-alive probe, the seconds between probes, and the number of\n\
+unanswered probes after which the connection is dropped.\n\
+\n\
+@item IPV6_V6ONLY\n\
+At level IPPROTO_IPV6, restricts an AF_INET6 socket to IPv6.  When it is\n\
+0, a listening socket also accepts IPv4 connections, whose peers are\n\
+reported as v4-mapped addresses such as ::ffff:127.0.0.1.  It must be set\n\
+before @code{bind}.\n\
 @end table\n\
+@seealso{getsockopt}\n\
 @end deftypefn")
 {
   if (args.length () != 4)
@@ -779,53 +8920,176 @@ should allow reuse of local addresses, if this is supported by the protocol.\n\
 
   int level = args(1).int_value();
   int opt = args(2).int_value();
-  int value = args(3).int_value();
   if (error_state)
     {
-      error ("setsockopt: LEVEL, OPT and VALUE must be integer values");
+      error ("setsockopt: LEVEL and OPT must be integer values");
+      return octave_value ();
+    }
+
+  int ret;
+  if (is_timeout_opt (level, opt))
+    {
+      const double t = args(3).double_value ();
+      if (error_state || t < 0)
+        {
+          error ("setsockopt: VALUE must be a non-negative number of seconds");
+          return octave_value ();
+        }
+#ifndef __WIN32__
+      struct timeval tv;
+      tv.tv_sec = time_t (t);
+      tv.tv_usec = suseconds_t ((t - tv.tv_sec) * 1e6);
+      ret = setsockopt (s, level, opt, &tv, sizeof (tv));
+#else
+      DWORD ms = DWORD (t * 1e3);
+      ret = setsockopt (s, level, opt, (const char*)&ms, sizeof (ms));
+#endif
+    }
+  else if (level == SOL_SOCKET && opt == SO_LINGER)
+    {
+      const octave_scalar_map value = args(3).scalar_map_value ();
+      struct linger l;
+      if (! error_state)
+        {
+          l.l_onoff = value.getfield ("onoff").bool_value ();
+          l.l_linger = value.getfield ("linger").int_value ();
+        }
+      if (error_state)
+        {
+          error ("setsockopt: VALUE must be a struct with the fields onoff and linger");
+          return octave_value ();
+        }
+      ret = setsockopt (s, level, opt, (const char*)&l, sizeof (l));
+    }
+  else
+    {
+      int value = args(3).int_value();
+      if (error_state)
+        {
+          error ("setsockopt: VALUE must be an integer value");
+          return octave_value ();
+        }
+      ret = setsockopt (s, level, opt, (const char*)&value, sizeof (value));
+    }
+  if (ret == -1)
+    error ("setsockopt failed with error %i (%s)", errno, strerror(errno));
+
+  return octave_value ();
+}
+
+// PKG_ADD: autoload ("getsockopt", which ("socket"));
+// PKG_DEL: try; autoload ("getsockopt", which ("socket"), "remove"); catch; end;
+// function to get options for the specified socket
+DEFUN_DLD(getsockopt,args,nargout, "\
+-*- texinfo -*-\n\
+@deftypefn {Loadable Function} {@var{value} =} getsockopt (@var{s}, @var{level}, @var{opt})\n\
+Get option for specified socket.\n\
+\n\
+Returns the value of the option @var{opt} at @var{level} of the socket\n\
+@var{s}, in the same form as given to @code{setsockopt}: a double number\n\
+of seconds for SO_RCVTIMEO and SO_SNDTIMEO, a struct for SO_LINGER and an\n\
+integer otherwise.\n\
+\n\
+In addition, TCP_INFO at level IPPROTO_TCP returns a struct with the\n\
+round trip time, congestion window and retransmits of a TCP connection,\n\
+as the @code{tcp_info} field of @code{socket_stats} (Linux only).\n\
+@seealso{setsockopt}\n\
+@end deftypefn")
+{
+  if (args.length () != 3)
+    {
+      print_usage ();
+      return octave_value ();
+    }
+
+  // Determine the socket on which to operate
+  const int s = get_socket (args(0));
+  if (error_state)
+    {
+      error ("getsockopt: S must be a valid socket");
+      return octave_value ();
+    }
+
+  int level = args(1).int_value();
+  int opt = args(2).int_value();
+  if (error_state)
+    {
+      error ("getsockopt: LEVEL and OPT must be integer values");
+      return octave_value ();
+    }
+
+#if defined (__linux__) && defined (TCP_INFO)
+  if (level == IPPROTO_TCP && opt == TCP_INFO)
+    {
+      const octave_value info = get_tcp_info (s);
+      if (info.is_empty ())
+        error ("getsockopt failed with error %i (%s)", errno, strerror(errno));
+      return info;
+    }
+#endif
+
+  if (is_timeout_opt (level, opt))
+    {
+#ifndef __WIN32__
+      struct timeval tv;
+      socklen_t len = sizeof (tv);
+      if (getsockopt (s, level, opt, &tv, &len) == -1)
+        {
+          error ("getsockopt failed with error %i (%s)", errno, strerror(errno));
+          return octave_value ();
+        }
+      return octave_value (tv.tv_sec + tv.tv_usec * 1e-6);
+#else
+      DWORD ms;
+      int len = sizeof (ms);
+      if (getsockopt (s, level, opt, (char*)&ms, &len) == -1)
+        {
+          error ("getsockopt failed with error %i (%s)", errno, strerror(errno));
+          return octave_value ();
+        }
+      return octave_value (ms * 1e-3);
+#endif
+    }
+  else if (level == SOL_SOCKET && opt == SO_LINGER)
+    {
+      struct linger l;
+      socklen_t len = sizeof (l);
+#ifndef __WIN32__
+      if (getsockopt (s, level, opt, &l, &len) == -1)
+#else
+      if (getsockopt (s, level, opt, (char*)&l, (int*)&len) == -1)
+#endif
+        {
+          error ("getsockopt failed with error %i (%s)", errno, strerror(errno));
+          return octave_value ();
+        }
+      octave_scalar_map value;
+      value.assign ("onoff", octave_value (l.l_onoff != 0));
+      value.assign ("linger", octave_value (int (l.l_linger)));
+      return octave_value (value);
+    }
+
+  // Most options are an int, some are a single byte on some systems
+  int value = 0;
+  socklen_t len = sizeof (value);
+#ifndef __WIN32__
+  int ret = getsockopt(s, level, opt, &value, &len);
+#else
+  int ret = getsockopt(s, level, opt, (char*)&value, (int*)&len);
+#endif
+  if (ret == -1)
+    {
+      error ("getsockopt failed with error %i (%s)", errno, strerror(errno));
       return octave_value ();
     }
-
-  int ret = setsockopt( s, level, opt, &value, sizeof(value) );
-  if (ret == -1)
-    error ("setsockopt failed with error %i (%s)", errno, strerror(errno));
-
-  return octave_value ();
-}
-
-// PKG_ADD: autoload ("getsockopt", which ("socket"));
-// PKG_DEL: try; autoload ("getsockopt", which ("socket"), "remove"); catch; end;
-// function to get options for the specified socket
-DEFUN_DLD(getsockopt,args,nargout, "\
--*- texinfo -*-\n\
-@deftypefn {Loadable Function} {@var{value} =} getsockopt (@var{s}, @var{level}, @var{opt})\n\
-Get option for specified socket. See also TODO getsockopt\n\
-@end deftypefn")
-{
-  if (args.length () != 3)
+  if (len == 1)
+    value = *reinterpret_cast<unsigned char*> (&value);
+  else if (len != sizeof (value))
     {
-      print_usage ();
+      error ("getsockopt: option value of unsupported size %d", int (len));
       return octave_value ();
     }
 
-  // Determine the socket on which to operate
-  const int s = get_socket (args(0));
-  if (error_state)
-    error ("getsockopt: S must be a valid socket");
-
-  int level = args(1).int_value();
-  int opt = args(2).int_value();
-  if (error_state)
-    error ("getsockopt: LEVEL and OPT must be integer values");
-
-  int value;
-  socklen_t len = 4;  //value is a int. TODO, this may be architecture dependent. Use int32 instead?
-  int ret = getsockopt(s, level, opt, &value, &len);
-  if (ret == -1)
-    error ("setsockopt failed with error %i (%s)", errno, strerror(errno));
-  if (len != 4)
-    error ("getsockopt: currently only int arguments are available for optval");
-
   return octave_value (value);
 }
 
@@ -916,3 +9180,831 @@ Get option for specified socket. See also TODO getsockopt\n\
 %! disconnect (server2);
 */
 
+/*
+%!function [server, client, server_data] = tcp_pair (port)
+%!  ## A server listening on PORT and both ends of a connection to it
+%!  server = socket (AF_INET, SOCK_STREAM, 0);
+%!  setsockopt (server, SOL_SOCKET, SO_REUSEADDR, 1);
+%!  bind (server, port);
+%!  listen (server, 1);
+%!  client = socket (AF_INET, SOCK_STREAM, 0);
+%!  connect (client, struct ("addr", "127.0.0.1", "port", port));
+%!  server_data = accept (server);
+%!endfunction
+*/
+
+/*
+%!test
+%! ## Send numeric arrays of any class without conversion
+%! [server, client, server_data] = tcp_pair (9002);
+%!
+%! a = rand (3, 4);
+%! assert (send (client, a), 8 * numel (a));
+%! [d, len] = recv (server_data, 1000, MSG_WAITALL);
+%! assert (len, 8 * numel (a));
+%! assert (typecast (d, "double"), a(:).');
+%!
+%! assert (send (client, int16 ([258 -2])), 4);
+%! assert (send (client, uint16 (258), "byteorder", "network"), 2);
+%! assert (send (client, single ([1 2]), 0, "byteorder", "ieee-le"), 8);
+%! d = recv (server_data, 14, MSG_WAITALL);
+%! assert (typecast (d(1:4), "int16"), int16 ([258 -2]));
+%! assert (d(5:6), uint8 ([1 2]));
+%! assert (d(7:14), uint8 ([0 0 128 63 0 0 0 64]));
+%!
+%! disconnect (client);
+%! disconnect (server_data);
+%! disconnect (server);
+*/
+
+/*
+%!test
+%! ## Receive typed and shaped arrays
+%! [server, client, server_data] = tcp_pair (9003);
+%!
+%! a = single (magic (4));
+%! send (client, a);
+%! [d, len] = recv (server_data, [], MSG_WAITALL, "class", "single", "dims", [4 4]);
+%! assert (len, 64);
+%! assert (d, a);
+%!
+%! send (client, uint32 ([1 65536]), "byteorder", "network");
+%! d = recv (server_data, 8, MSG_WAITALL, "class", "uint32", "byteorder", "network");
+%! assert (d, uint32 ([1 65536]));
+%!
+%! ## An incomplete element is kept for the next receive
+%! send (client, uint8 ([1 2 3]));
+%! [d, len] = recvall (server_data, 4, "class", "int16", "timeout", 0.5);
+%! assert (d, typecast (uint8 ([1 2]), "int16"));
+%! assert (len, 2);
+%! send (client, uint8 (4));
+%! [d, len] = recv (server_data, 2, MSG_WAITALL, "class", "int16");
+%! assert (d, typecast (uint8 ([3 4]), "int16"));
+%! assert (len, 2);
+%!
+%! fail ("recv (server_data, 3, 0, 'class', 'int16')", "multiple");
+%! fail ("recv (server_data, 8, 0, 'dims', [2 2])", "does not match");
+%!
+%! disconnect (client);
+%! disconnect (server_data);
+%! disconnect (server);
+*/
+
+/*
+%!test
+%! ## Transfer large arrays completely
+%! [server, client, server_data] = tcp_pair (9004);
+%!
+%! a = rand (100, 50);
+%! assert (sendall (client, a), 8 * numel (a));
+%! [d, len] = recvall (server_data, [], "class", "double", "dims", size (a));
+%! assert (len, 8 * numel (a));
+%! assert (d, a);
+%!
+%! ## Nothing more to read, so this times out with a short count
+%! [d, len] = recvall (server_data, 8, MSG_DONTWAIT, "timeout", 0.05);
+%! assert (len, 0);
+%! assert (isempty (d));
+%!
+%! disconnect (client);
+%! disconnect (server_data);
+%! disconnect (server);
+*/
+
+/*
+%!test
+%! ## Wait on several sockets at once
+%! server = socket (AF_INET, SOCK_STREAM, 0);
+%! setsockopt (server, SOL_SOCKET, SO_REUSEADDR, 1);
+%! bind (server, 9005);
+%! listen (server, 2);
+%! c1 = socket (AF_INET, SOCK_STREAM, 0);
+%! connect (c1, struct ("addr", "127.0.0.1", "port", 9005));
+%! s1 = accept (server);
+%! c2 = socket (AF_INET, SOCK_STREAM, 0);
+%! connect (c2, struct ("addr", "127.0.0.1", "port", 9005));
+%! s2 = accept (server);
+%!
+%! [revents, n] = poll ([s1 s2], POLLIN, 0);
+%! assert (n, 0);
+%! assert (revents, [0 0]);
+%!
+%! send (c2, "ping");
+%! [revents, n] = poll ([s1 s2], POLLIN, 1000);
+%! assert (n, 1);
+%! assert (bitand (revents, POLLIN) != 0, [false true]);
+%!
+%! [revents, n] = poll ([s1; s2], [POLLIN; POLLOUT], 1000);
+%! assert (n, 1);
+%! assert (revents, [0; POLLOUT]);
+%!
+%! cellfun (@disconnect, {c1, c2, s1, s2, server});
+*/
+
+/*
+%!test
+%! ## Keep a set of sockets in an event loop
+%! server = socket (AF_INET, SOCK_STREAM, 0);
+%! setsockopt (server, SOL_SOCKET, SO_REUSEADDR, 1);
+%! bind (server, 9006);
+%! listen (server, 2);
+%! c1 = socket (AF_INET, SOCK_STREAM, 0);
+%! connect (c1, struct ("addr", "127.0.0.1", "port", 9006));
+%! s1 = accept (server);
+%! c2 = socket (AF_INET, SOCK_STREAM, 0);
+%! connect (c2, struct ("addr", "127.0.0.1", "port", 9006));
+%! s2 = accept (server);
+%!
+%! loop = evloop_create ();
+%! evloop_add (loop, [s1 s2], EPOLLIN);
+%! [fds, events] = evloop_wait (loop, 10, 0);
+%! assert (isempty (fds) && isempty (events));
+%!
+%! send (c1, "ping");
+%! [fds, events] = evloop_wait (loop, 10, 1000);
+%! assert (fds, s1);
+%! assert (events, EPOLLIN);
+%!
+%! ## Edge-triggered sockets are reported once per arrival
+%! evloop_mod (loop, s1, bitor (EPOLLIN, EPOLLET));
+%! fds = evloop_wait (loop, 10, 0);
+%! assert (fds, s1);
+%! fds = evloop_wait (loop, 10, 0);
+%! assert (isempty (fds));
+%!
+%! evloop_del (loop, s1);
+%! send (c2, "pong");
+%! fds = evloop_wait (loop, 10, 1000);
+%! assert (fds, s2);
+%!
+%! cellfun (@disconnect, {loop, c1, c2, s1, s2, server});
+*/
+
+/*
+%!test
+%! ## Exchange datagrams, one at a time and in batches
+%! a = socket (AF_INET, SOCK_DGRAM, 0);
+%! bind (a, 9007);
+%! b = socket (AF_INET, SOCK_DGRAM, 0);
+%! bind (b, 9008);
+%! to_a = struct ("addr", "127.0.0.1", "port", 9007);
+%!
+%! assert (sendto (b, "hello", to_a), 5);
+%! [d, len, from] = recvfrom (a, 100);
+%! assert (char (d), "hello");
+%! assert (len, 5);
+%! assert (from, struct ("addr", "127.0.0.1", "port", 9008));
+%! sendto (a, int32 (42), from);
+%! assert (recvfrom (b, 4, "class", "int32"), int32 (42));
+%!
+%! assert (sendmmsg (b, {"one", uint8([1 2]), "three"}, to_a), 3);
+%! [d, lens, from] = recvmmsg (a, 10, 8);
+%! assert (lens, [3 2 5]);
+%! assert (size (d), [8 3]);
+%! assert (char (d(1:5, 3).'), "three");
+%! assert ([from.port], [9008 9008 9008]);
+%!
+%! [d, lens] = recvmmsg (a, 10, 8, MSG_DONTWAIT);
+%! assert (isempty (lens));
+%!
+%! disconnect (a);
+%! disconnect (b);
+*/
+
+/*
+%!test
+%! ## Exchange whole messages over a stream
+%! [server, client, server_data] = tcp_pair (9009);
+%!
+%! [d, len] = recv_msg (server_data, MSG_DONTWAIT);
+%! assert (len, -1);
+%! assert (isempty (d));
+%!
+%! ## Several messages arriving together are returned one by one
+%! assert (send_msg (client, "first"), 5);
+%! assert (send_msg (client, ""), 0);
+%! assert (send_msg (client, [1.5 2.5]), 16);
+%! assert (char (recv_msg (server_data)), "first");
+%! [d, len] = recv_msg (server_data);
+%! assert (len, 0);
+%! assert (recv_msg (server_data, "class", "double"), [1.5 2.5]);
+%!
+%! ## A message arriving in pieces is reassembled
+%! send (client, uint8 ([0 0 0 3 65]));
+%! [d, len] = recv_msg (server_data, MSG_DONTWAIT);
+%! assert (len, -1);
+%! send (client, "BC");
+%! assert (char (recv_msg (server_data)), "ABC");
+%!
+%! ## Single bytes, and a message longer than MAXLEN
+%! assert (send_msg (client, uint8 (7)), 1);
+%! assert (recv_msg (server_data), uint8 (7));
+%! assert (send_msg (client, 1:4), 32);
+%! fail ("recv_msg (server_data, 'maxlen', 16)", "longer than MAXLEN");
+%!
+%! disconnect (client);
+%! [d, len] = recv_msg (server_data);
+%! assert (len, -1);
+%! disconnect (server_data);
+%! disconnect (server);
+*/
+
+/*
+%!test
+%! ## Exchange matrices in binary form
+%! [server, client, server_data] = tcp_pair (9010);
+%!
+%! values = {rand(30, 20), single(rand(2, 3, 4)) + 1i, int64([-1 2^40]), ...
+%!           true(3, 1), "text", zeros(0, 3, "uint16"), 1:5, pi};
+%! for i = 1:numel (values)
+%!   send_matrix (client, values{i});
+%! endfor
+%! for i = 1:numel (values)
+%!   a = recv_matrix (server_data);
+%!   assert (a, values{i});
+%!   assert (class (a), class (values{i}));
+%! endfor
+%!
+%! ## A header announcing more than MAXLEN bytes
+%! send_matrix (client, zeros (3, 4));
+%! fail ("recv_matrix (server_data, 'maxlen', 64)", "longer than MAXLEN");
+%! [~, count] = recvall (server_data, 96);
+%! assert (count, 96);
+%!
+%! disconnect (client);
+%! [a, count] = recv_matrix (server_data);
+%! assert (count, -1);
+%! disconnect (server_data);
+%! disconnect (server);
+*/
+
+/*
+%!test
+%! ## Receive in the background while octave is busy
+%! [server, client, server_data] = tcp_pair (9011);
+%!
+%! recv_async_start (server_data, 1000);
+%! [d, count] = recv_async_read (server_data, 10);
+%! assert (count, 0);
+%!
+%! a = uint8 (mod (0:2999, 256));
+%! sendall (client, a, "timeout", 1);
+%! disconnect (client);
+%! b = [];
+%! do
+%!   [d, count] = recv_async_read (server_data, 700, "timeout", 1);
+%!   b = [b d];
+%! until (count == -1)
+%! assert (b, a);
+%!
+%! stats = recv_async_stats (server_data);
+%! assert (stats.ring_bytes, 1024);
+%! assert (stats.bytes_received, 3000);
+%! assert (stats.running, false);
+%! recv_async_stop (server_data);
+%! disconnect (server_data);
+%! disconnect (server);
+*/
+
+/*
+%!test
+%! ## Sockets are descriptors that close themselves when cleared
+%! server = socket (AF_INET, SOCK_STREAM, 0);
+%! assert (isnumeric (server) && isscalar (server));
+%! setsockopt (server, SOL_SOCKET, SO_REUSEADDR, 1);
+%! bind (server, 9012);
+%! listen (server, 1);
+%! client = socket (AF_INET, SOCK_STREAM, 0);
+%! connect (client, struct ("addr", "127.0.0.1", "port", 9012));
+%! [server_data, info] = accept (server);
+%! fds = [server client server_data];
+%! assert (fds(2), socket_info (client).fd);
+%! assert (fds(3), socket_info (server_data).fd);
+%!
+%! assert (send (client, "hello"), 5);
+%! assert (char (recv (server_data, 5)), "hello");
+%! info = socket_info (client);
+%! assert (info.fd, double (client));
+%! assert (info.open, true);
+%! assert ([info.family info.type], [AF_INET SOCK_STREAM]);
+%! assert (info.peer, struct ("addr", "127.0.0.1", "port", 9012));
+%! assert (info.bytes_sent, 5);
+%! assert (socket_info (server_data).bytes_received, 5);
+%! assert (socket_info (server_data).type, SOCK_STREAM);
+%!
+%! ## Clearing the last copy closes the connection
+%! copy = client;
+%! clear client
+%! assert (socket_info (copy).open, true);
+%! clear copy
+%! [d, len] = recv (server_data, 10);
+%! assert (len, 0);
+%!
+%! disconnect (server_data);
+%! assert (socket_info (server_data).open, false);
+%! clear server_data
+%! disconnect (server);
+*/
+
+/*
+%!test
+%! ## Count and time the system calls made on a socket
+%! [server, client, server_data] = tcp_pair (9013);
+%!
+%! socket_stats ("enable");
+%! unwind_protect
+%!   socket_stats ("reset");
+%!   send (client, "hello");
+%!   [d, len] = recv (server_data, 100);
+%!   [d, len] = recv (server_data, 100, MSG_DONTWAIT);
+%!   assert (len, -1);
+%!
+%!   stats = socket_stats (client);
+%!   assert (stats.enabled, true);
+%!   assert (stats.bytes_sent, 5);
+%!   assert (stats.send_calls, 1);
+%!   assert (sum (stats.send_hist), 1);
+%!   assert (numel (stats.hist_edges), numel (stats.send_hist));
+%!   if (! isempty (stats.tcp_info))
+%!     assert (stats.tcp_info.rtt >= 0);
+%!   endif
+%!
+%!   stats = socket_stats (server_data, "reset");
+%!   assert (stats.recv_calls, 2);
+%!   assert (stats.eagain, 1);
+%!   assert (stats.short_reads, 1);
+%!   assert (socket_stats (server_data).recv_calls, 0);
+%!
+%!   stats = socket_stats ();
+%!   assert (stats.bytes_received, 5);
+%!   assert (stats.send_calls, 1);
+%! unwind_protect_cleanup
+%!   socket_stats ("disable");
+%! end_unwind_protect
+%!
+%! send (client, "hello");
+%! assert (socket_stats (client).send_calls, 1);
+%! assert (socket_stats (client).bytes_sent, 10);
+%!
+%! disconnect (client);
+%! disconnect (server_data);
+%! disconnect (server);
+*/
+
+/*
+%!test
+%! ## Connect with a timeout, and many sockets at once
+%! server = socket (AF_INET, SOCK_STREAM, 0);
+%! setsockopt (server, SOL_SOCKET, SO_REUSEADDR, 1);
+%! bind (server, 9014);
+%! listen (server, 4);
+%! info = struct ("addr", "127.0.0.1", "port", 9014);
+%!
+%! client = socket (AF_INET, SOCK_STREAM, 0);
+%! assert (connect (client, info, "timeout", 1), 0);
+%! server_data = accept (server);
+%! send (client, "hello");
+%! assert (char (recv (server_data, 5)), "hello");
+%!
+%! c = {socket(AF_INET, SOCK_STREAM, 0), socket(AF_INET, SOCK_STREAM, 0), ...
+%!      socket(AF_INET, SOCK_STREAM, 0)};
+%! infos = {info, info, struct("addr", "127.0.0.1", "port", 9015)};
+%! [status, msg] = connect_many (c, infos, "timeout", 1);
+%! assert (status, [0 0 -1]);
+%! assert (msg{1}, "");
+%! assert (! isempty (msg{3}));
+%! a1 = accept (server);
+%! a2 = accept (server);
+%! send (c{2}, "world");
+%! assert (char (recv (a2, 5)), "world");
+%!
+%! cellfun (@disconnect, [c {a1, a2, client, server_data, server}]);
+*/
+
+/*
+%!test
+%! ## Resolve host names through the cache
+%! resolver_flush ();
+%! info = getaddrinfo ("127.0.0.1", AF_INET);
+%! assert (all ([info.family] == AF_INET));
+%! assert (unique ({info.addr}), {"127.0.0.1"});
+%! assert (any ([info.socktype] == SOCK_STREAM));
+%! assert (gethostbyname ("127.0.0.1"), "127.0.0.1");
+%! stats = resolver_stats ();
+%! assert (stats.lookups, 1);
+%! assert (stats.hits, 1);
+%!
+%! fail ("getaddrinfo ('no-such-host.invalid')", "could not resolve");
+%! fail ("getaddrinfo ('no-such-host.invalid')", "could not resolve");
+%! stats = resolver_stats ();
+%! assert (stats.failures, 1);
+%! assert (stats.negative_hits, 1);
+%!
+%! resolver_flush ("no-such-host.invalid");
+%! assert (resolver_stats ().entries, 1);
+%!
+%! ## A time to live of 0 keeps nothing in the cache
+%! resolver_flush ();
+%! assert (resolver_stats ("ttl", 0).ttl, 0);
+%! gethostbyname ("127.0.0.1");
+%! gethostbyname ("127.0.0.1");
+%! stats = resolver_stats ();
+%! assert (stats.lookups, 2);
+%! assert (stats.entries, 0);
+%! resolver_stats ("ttl", 60);
+%! resolver_flush ();
+*/
+
+/*
+%!test
+%! ## Connect over IPv6, and accept IPv4 peers on a dual-stack socket
+%! server = socket (AF_INET6, SOCK_STREAM, 0);
+%! setsockopt (server, SOL_SOCKET, SO_REUSEADDR, 1);
+%! setsockopt (server, IPPROTO_IPV6, IPV6_V6ONLY, 0);
+%! bind (server, 9016);
+%! listen (server, 2);
+%!
+%! client = socket (AF_INET6, SOCK_STREAM, 0);
+%! connect (client, struct ("addr", "::1", "port", 9016));
+%! [server_data, info] = accept (server);
+%! assert (info.sin_family, AF_INET6);
+%! assert (info.addr, "::1");
+%! assert (info.port, socket_info (client).local.port);
+%! send (client, "hello");
+%! assert (char (recv (server_data, 5)), "hello");
+%!
+%! client4 = socket (AF_INET, SOCK_STREAM, 0);
+%! connect (client4, struct ("addr", "127.0.0.1", "port", 9016));
+%! [server_data4, info] = accept (server);
+%! assert (info.addr, "::ffff:127.0.0.1");
+%! assert (info.port, socket_info (client4).local.port);
+%!
+%! cellfun (@disconnect, {client, client4, server_data, server_data4, server});
+*/
+
+/*
+%!test
+%! ## Bind to one local address, and share a port between sockets
+%! server = socket (AF_INET, SOCK_STREAM, 0);
+%! setsockopt (server, SOL_SOCKET, SO_REUSEADDR, 1);
+%! bind (server, struct ("addr", "127.0.0.1", "port", 9017));
+%! assert (socket_info (server).local, struct ("addr", "127.0.0.1", "port", 9017));
+%! disconnect (server);
+%!
+%! ## The constant exists everywhere, but fails where the option does not
+%! try
+%!   reuseport = SO_REUSEPORT;
+%! catch err
+%!   assert (err.message, "SO_REUSEPORT not supported on this platform");
+%!   reuseport = [];
+%! end_try_catch
+%! if (! isempty (reuseport))
+%!   s1 = socket (AF_INET, SOCK_STREAM, 0);
+%!   setsockopt (s1, SOL_SOCKET, reuseport, 1);
+%!   bind (s1, struct ("addr", "", "port", 9018));
+%!   listen (s1, 1);
+%!   s2 = socket (AF_INET, SOCK_STREAM, 0);
+%!   setsockopt (s2, SOL_SOCKET, reuseport, 1);
+%!   bind (s2, 9018);
+%!   listen (s2, 1);
+%!   try
+%!     reuseport_steer (s1, "cpu", 2);
+%!   catch err
+%!     assert (err.message, "reuseport_steer: not supported on this platform");
+%!   end_try_catch
+%!   disconnect (s1);
+%!   disconnect (s2);
+%! endif
+*/
+
+/*
+%!test
+%! ## Set and get typed socket options
+%! s = socket (AF_INET, SOCK_STREAM, 0);
+%! setsockopt (s, IPPROTO_TCP, TCP_NODELAY, 1);
+%! assert (getsockopt (s, IPPROTO_TCP, TCP_NODELAY) != 0);
+%! setsockopt (s, SOL_SOCKET, SO_RCVBUF, 65536);
+%! assert (getsockopt (s, SOL_SOCKET, SO_RCVBUF) >= 65536);
+%! setsockopt (s, SOL_SOCKET, SO_RCVTIMEO, 1.5);
+%! assert (getsockopt (s, SOL_SOCKET, SO_RCVTIMEO), 1.5, 1e-2);
+%! setsockopt (s, SOL_SOCKET, SO_LINGER, struct ("onoff", true, "linger", 2));
+%! assert (getsockopt (s, SOL_SOCKET, SO_LINGER), struct ("onoff", true, "linger", 2));
+%! disconnect (s);
+*/
+
+/*
+%!test
+%! ## Stream a file over a socket into another file
+%! [server, client, server_data] = tcp_pair (9019);
+%!
+%! src = tempname ();
+%! dst = tempname ();
+%! unwind_protect
+%!   a = uint8 (mod (0:99999, 251));
+%!   fid = fopen (src, "w");
+%!   fwrite (fid, a, "uint8");
+%!   fclose (fid);
+%!
+%!   assert (sendfile (client, src, 1000, 50000, "timeout", 5), 50000);
+%!   assert (recv_to_file (server_data, dst, 50000, "timeout", 5), 50000);
+%!   fid = fopen (dst, "r");
+%!   b = fread (fid, Inf, "uint8=>uint8")';
+%!   fclose (fid);
+%!   assert (b, a(1001:51000));
+%!
+%!   ## The rest of the file, until the peer shuts down
+%!   assert (sendfile (client, src, 51000), 49000);
+%!   disconnect (client);
+%!   assert (recv_to_file (server_data, dst), 49000);
+%! unwind_protect_cleanup
+%!   unlink (src);
+%!   unlink (dst);
+%! end_unwind_protect
+%! disconnect (server_data);
+%! disconnect (server);
+*/
+
+/*
+%!test
+%! ## Receive straight into a memory-mapped file
+%! [server, client, server_data] = tcp_pair (9020);
+%!
+%! dst = tempname ();
+%! unwind_protect
+%!   a = reshape (1:3000, 100, 30);
+%!   sendall (client, a, "byteorder", "network");
+%!   [count, nread] = recv_mmap (server_data, dst, 24000, "double", [100 30],
+%!                               "byteorder", "network", "timeout", 5);
+%!   assert ([count nread], [3000 24000]);
+%!   fid = fopen (dst, "r");
+%!   b = fread (fid, [100 30], "double");
+%!   fclose (fid);
+%!   assert (b, a);
+%!
+%!   ## A short transfer truncates the file
+%!   send (client, uint8 (1:10));
+%!   disconnect (client);
+%!   [count, nread] = recv_mmap (server_data, dst, 4096, "uint32");
+%!   assert ([count nread], [2 10]);
+%!   assert (stat (dst).size, 10);
+%! unwind_protect_cleanup
+%!   unlink (dst);
+%! end_unwind_protect
+%! disconnect (server_data);
+%! disconnect (server);
+*/
+
+/*
+%!test
+%! ## Zero-copy send, falling back to copying where unsupported
+%! [server, client, server_data] = tcp_pair (9021);
+%!
+%! a = rand (1, 1000);
+%! assert (send (client, a, "zerocopy", true), 8000);
+%! [b, len] = recv (server_data, 8000, MSG_WAITALL, "class", "double",
+%!                 "dims", [1 1000]);
+%! assert (len, 8000);
+%! assert (b, a);
+%! [completed, pending] = send_completions (client, 5000);
+%! assert (pending, 0);
+%! st = socket_stats (client);
+%! assert (st.zerocopy_completions, st.zerocopy_sends);
+%! assert (completed, st.zerocopy_sends);
+%! disconnect (client);
+%! disconnect (server_data);
+%! disconnect (server);
+*/
+
+/*
+%!test
+%! ## Batched accept, send and recv through an io_uring
+%! server = socket (AF_INET, SOCK_STREAM, 0);
+%! setsockopt (server, SOL_SOCKET, SO_REUSEADDR, 1);
+%! bind (server, 9022);
+%! listen (server, 1);
+%! ring = uring_create (16);
+%! unwind_protect
+%!   tag = uring_queue (ring, "accept", server);
+%!   assert (uring_submit (ring), 1);
+%!   client = socket (AF_INET, SOCK_STREAM, 0);
+%!   connect (client, struct ("addr", "127.0.0.1", "port", 9022));
+%!   [tags, results, data] = uring_reap (ring, 1, 5000);
+%!   assert (tags, tag);
+%!   assert (results >= 0);
+%!   server_data = data{1};
+%!   assert (server_data, results);
+%!
+%!   send_tag = uring_queue (ring, "send", client, uint8 (1:100));
+%!   recv_tag = uring_queue (ring, "recv", server_data, 100, "flags", MSG_WAITALL);
+%!   [tags, results, data, more] = uring_reap (ring, 2, 5000);
+%!   assert (sort (tags), sort ([send_tag; recv_tag]));
+%!   assert (results, [100; 100]);
+%!   assert (data{tags == recv_tag}, uint8 (1:100));
+%!   assert (isempty (data{tags == send_tag}));
+%!   assert (more, [false; false]);
+%!   disconnect (server_data);
+%!   disconnect (client);
+%! unwind_protect_cleanup
+%!   disconnect (ring);
+%! end_unwind_protect
+%! disconnect (server);
+*/
+
+/*
+%!test
+%! ## Drain the backlog in one call
+%! server = socket (AF_INET, SOCK_STREAM, 0);
+%! setsockopt (server, SOL_SOCKET, SO_REUSEADDR, 1);
+%! bind (server, 9023);
+%! listen (server, 8);
+%! [fds, info] = accept_many (server);
+%! assert (isempty (fds));
+%! clients = cell (1, 3);
+%! for i = 1:3
+%!   clients{i} = socket (AF_INET, SOCK_STREAM, 0);
+%!   connect (clients{i}, struct ("addr", "127.0.0.1", "port", 9023));
+%! endfor
+%! [fds, info] = accept_many (server, 2, 1000);
+%! assert (size (fds), [2 1]);
+%! assert ([info.family], [AF_INET AF_INET]);
+%! assert ({info.addr}, {"127.0.0.1", "127.0.0.1"});
+%! [more_fds, more_info] = accept_many (server, [], 1000);
+%! assert (numel (more_fds), 1);
+%! assert (sort ([info.port more_info.port]),
+%!         sort (cellfun (@(c) socket_info (c).local.port, clients)));
+%! assert (iscell (fds) && iscell (more_fds));
+%! cellfun (@disconnect, [fds; more_fds]);
+%! cellfun (@disconnect, clients);
+%! disconnect (server);
+*/
+
+/*
+%!test
+%! ## A pool reuses connections and drops the ones the server closed
+%! server = socket (AF_INET, SOCK_STREAM, 0);
+%! setsockopt (server, SOL_SOCKET, SO_REUSEADDR, 1);
+%! bind (server, 9024);
+%! listen (server, 4);
+%! pool = connpool_create ("127.0.0.1", 9024, 2, "keepalive", true);
+%! unwind_protect
+%!   c1 = connpool_get (pool);
+%!   s1 = accept (server);
+%!   assert (getsockopt (c1, SOL_SOCKET, SO_KEEPALIVE) != 0);
+%!   connpool_put (pool, c1);
+%!   c2 = connpool_get (pool);
+%!   assert (double (c2), double (c1));
+%!   c3 = connpool_get (pool);
+%!   s3 = accept (server);
+%!   fail ("connpool_get (pool)", "in use");
+%!   connpool_put (pool, c2);
+%!   connpool_put (pool, c3);
+%!
+%!   ## The server closes the most recently returned one
+%!   disconnect (s3);
+%!   pause (0.1);
+%!   c4 = connpool_get (pool);
+%!   assert (double (c4), double (c1));
+%!   st = connpool_stats (pool);
+%!   assert ([st.connects st.reuses st.dead_evictions st.idle st.in_use],
+%!           [2 2 1 0 1]);
+%!   connpool_put (pool, c4, true);
+%!   assert (connpool_stats (pool).in_use, 0);
+%!   disconnect (s1);
+%! unwind_protect_cleanup
+%!   connpool_close (pool);
+%! end_unwind_protect
+%! disconnect (server);
+*/
+
+/*
+%!test
+%! ## Fan-out to several sockets, queueing for a slow one
+%! server = socket (AF_INET, SOCK_STREAM, 0);
+%! setsockopt (server, SOL_SOCKET, SO_REUSEADDR, 1);
+%! bind (server, 9025);
+%! listen (server, 2);
+%! c1 = socket (AF_INET, SOCK_STREAM, 0);
+%! connect (c1, struct ("addr", "127.0.0.1", "port", 9025));
+%! s1 = accept (server);
+%! c2 = socket (AF_INET, SOCK_STREAM, 0);
+%! connect (c2, struct ("addr", "127.0.0.1", "port", 9025));
+%! s2 = accept (server);
+%!
+%! a = uint32 (1:10);
+%! [sent, queued] = send_multi ({s1, s2}, a, "byteorder", "network");
+%! assert (sent, [40 40]);
+%! assert (queued, [0 0]);
+%! assert (recv (c1, 40, MSG_WAITALL, "class", "uint32", "byteorder", "network"), a);
+%! assert (recv (c2, 40, MSG_WAITALL, "class", "uint32", "byteorder", "network"), a);
+%!
+%! ## Nobody reads c2, so its kernel buffers fill up and the rest queues
+%! big = zeros (1, 2^20, "uint8");
+%! total = 0;
+%! do
+%!   [sent, queued] = send_multi (s2, big, "max_queue", 2^22);
+%!   total += max (sent, 0);
+%! until (queued > 0 || total > 2^28)
+%! assert (queued > 0);
+%! sent = send_multi (s2, big, "max_queue", queued);
+%! assert (sent, -errno ("ENOBUFS"));
+%! disconnect (c2);
+%! disconnect (s2);
+%! disconnect (c1);
+%! disconnect (s1);
+%! disconnect (server);
+*/
+
+/*
+%!test
+%! ## AF_UNIX sockets on a path and in the abstract namespace
+%! path = tempname ();
+%! server = socket (AF_UNIX, SOCK_STREAM, 0);
+%! unwind_protect
+%!   bind (server, path);
+%!   listen (server, 1);
+%!   assert (socket_info (server).local.addr, path);
+%!   client = socket (AF_UNIX, SOCK_STREAM, 0);
+%!   connect (client, path);
+%!   server_data = accept (server);
+%!   send (client, uint8 (1:10));
+%!   assert (recv (server_data, 10, MSG_WAITALL), uint8 (1:10));
+%!   disconnect (client);
+%!   disconnect (server_data);
+%! unwind_protect_cleanup
+%!   disconnect (server);
+%!   unlink (path);
+%! end_unwind_protect
+%!
+%! if (strcmp (uname ().sysname, "Linux"))
+%!   name = sprintf ("@octave-sockets-test-%d", getpid ());
+%!   server = socket (AF_UNIX, SOCK_STREAM, 0);
+%!   bind (server, struct ("addr", name));
+%!   listen (server, 1);
+%!   assert (socket_info (server).local.addr, name);
+%!   client = socket (AF_UNIX, SOCK_STREAM, 0);
+%!   connect (client, struct ("addr", name));
+%!   server_data = accept (server);
+%!   assert (send (server_data, "abc"), 3);
+%!   assert (char (recv (client, 3, MSG_WAITALL)), "abc");
+%!   disconnect (client);
+%!   disconnect (server_data);
+%!   disconnect (server);
+%! endif
+*/
+
+/*
+%!test
+%! ## A connected pair
+%! [s1, s2] = socketpair ();
+%! assert (socket_info (s1).family, AF_UNIX);
+%! assert (sendall (s1, 1:4), 32);
+%! assert (recv (s2, 32, MSG_WAITALL, "class", "double"), 1:4);
+%! disconnect (s1);
+%! [~, len] = recv (s2, 1);
+%! assert (len, 0);
+%! disconnect (s2);
+*/
+
+/*
+%!test
+%! ## Arrays through a shared memory channel, wrapping around the ring
+%! if (strcmp (uname ().sysname, "Linux"))
+%!   [s1, s2] = socketpair ();
+%!   w = shm_channel_create (s1, 8192);
+%!   r = shm_channel_open (s2, "timeout", 5);
+%!   a = {magic(4), [1+2i, 3-4i], int32 (reshape (1:24, 2, 3, 4)), "text", ...
+%!        true (3, 1), single (ones (30, 20))};
+%!   nbytes = [128, 32, 96, 4, 3, 2400];
+%!   for k = 1:3
+%!     for i = 1:numel (a)
+%!       assert (shm_channel_send (w, a{i}), nbytes(i));
+%!       [b, len] = shm_channel_recv (r, "timeout", 5);
+%!       assert (b, a{i});
+%!       assert (len, nbytes(i));
+%!     endfor
+%!   endfor
+%!   fail ("shm_channel_send (w, zeros (100))", "ring has");
+%!   shm_channel_close (w);
+%!   disconnect (s1);
+%!   [b, len] = shm_channel_recv (r);
+%!   assert (len, -1);
+%!   shm_channel_close (r);
+%!   disconnect (s2);
+%! endif
+%!test
+%! ## Many small arrays through a large ring: the answers of the reader
+%! ## must not pile up in the socket, and closing the socket drops the channel
+%! if (strcmp (uname ().sysname, "Linux"))
+%!   [s1, s2] = socketpair ();
+%!   w = shm_channel_create (s1, 2^20);
+%!   r = shm_channel_open (s2, "timeout", 5);
+%!   for i = 1:50000
+%!     assert (shm_channel_send (w, i), 8);
+%!     assert (shm_channel_recv (r, "timeout", 5), i);
+%!   endfor
+%!   disconnect (s1);
+%!   disconnect (s2);
+%!   fail ("shm_channel_send (w, 5)", "must be a channel");
+%!   fail ("shm_channel_recv (r)", "must be a channel");
+%! endif
+*/